@@ -0,0 +1,285 @@
+// Replays recorded games and scores every move with the engine, to find the moves that threw a game away.
+//
+// Usage: "Connect Four Analyzer" --input file [--output file] [--depth N] [--threads N] [--table MB]
+//                                [--threshold N] [--window-count]
+//
+// The input has one game per line, the columns played (0-6, first player first) as the first word.
+// Everything after it is ignored, so the arena's --output works as input. Empty lines and lines
+// starting with # are skipped. A game ends at the first four in a row.
+//
+// Every position is searched with alpha-beta to --depth, once for the best move and once more for the
+// move that was played when it's a different one. Both scores are for the player to move. The output
+// (standard output without --output) has one line per move:
+//
+//  game ply player column score best bestScore loss flag
+//
+// game counts the games of the input from 0, player is 1 for the first player and 2 for the second.
+// loss is how much worse the move was than the best one. The flag is "blunder" when the move gave up
+// a win, walked into a loss or lost at least --threshold points, "-" otherwise.
+//
+// Boards are scored with PatternScoring, --window-count uses SimpleScoring like the old searches.
+
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConnectFour.h"
+#include "ConnectFourAI.h"
+#include "TranspositionTable.h"
+
+// One move of a recorded game, and what the engine thinks of it
+struct AnalyzedMove
+{
+    int game;
+    int ply;
+    std::string moves;  // The columns before this move
+
+    int column;
+    int score = 0;
+    int best = NIL;
+    int bestScore = 0;
+    bool blunder = false;
+};
+
+Player Opponent(Player player)
+{
+    return player == Player::AI ? Player::HUMAN : Player::AI;
+}
+
+// The next line without its length limit, false at the end of the file
+bool ReadLine(FILE* file, std::string& line)
+{
+    line.clear();
+
+    char buffer[1024];
+    while (fgets(buffer, sizeof(buffer), file))
+    {
+        line += buffer;
+        if (line.back() == '\n') return true;
+    }
+
+    // The last line doesn't need a line break
+    return !line.empty();
+}
+
+// Every move of every game up to its first four in a row. Games with an illegal move are left out.
+std::vector<AnalyzedMove> ReadGames(FILE* file, int& gameCount, int& skippedGames)
+{
+    std::vector<AnalyzedMove> moves;
+    gameCount = 0;
+    skippedGames = 0;
+
+    std::string line;
+    while (ReadLine(file, line))
+    {
+        const char* text = line.c_str();
+        while (*text == ' ' || *text == '\t') text++;
+        if (*text == '#' || *text == '\n' || *text == '\r' || *text == 0) continue;
+
+        int game = gameCount++;
+
+        ConnectFourBoard board;
+        board.ResetBoard();
+
+        // The first player is HUMAN on the board, like everywhere else
+        Player player = Player::HUMAN;
+        std::string played;
+        std::vector<AnalyzedMove> gameMoves;
+        bool legal = true;
+
+        for (; *text >= '0' && *text <= '9'; text++)
+        {
+            int column = *text - '0';
+            if (column >= ConnectFourBoard::COLUMNS || !board.DropCoin(column, player))
+            {
+                legal = false;
+                break;
+            }
+
+            AnalyzedMove move;
+            move.game = game;
+            move.ply = (int)played.size();
+            move.moves = played;
+            move.column = column;
+            gameMoves.push_back(move);
+
+            played += *text;
+
+            // Anything after the winning move didn't happen on a real board
+            if (ConnectFourBoard::FourInARow(board.GetCoins(player))) break;
+
+            player = Opponent(player);
+        }
+
+        if (!legal)
+        {
+            fprintf(stderr, "Game %i has an illegal move after \"%s\", left out\n", game, played.c_str());
+            skippedGames++;
+            continue;
+        }
+
+        moves.insert(moves.end(), gameMoves.begin(), gameMoves.end());
+    }
+
+    return moves;
+}
+
+// Search score (for the AI) as a score for the player
+int ScoreFor(Player player, int score)
+{
+    return player == Player::AI ? score : -score;
+}
+
+void AnalyzeMove(AnalyzedMove& move, int depth, Evaluation evaluation, int threshold, TranspositionTable& table)
+{
+    ConnectFourBoard board;
+    board.ResetBoard();
+
+    Player player = Player::HUMAN;
+    for (char c : move.moves)
+    {
+        board.DropCoin(c - '0', player);
+        player = Opponent(player);
+    }
+    board.SetPlayerTurn(player);
+
+    SearchContext context;
+    context.transpositionTable = &table;
+    context.evaluation = evaluation;
+
+    ColumnScore best = AlphaBetaPlay(board, depth, player, context);
+    move.best = best[0];
+    move.bestScore = ScoreFor(player, best[1]);
+    move.score = move.bestScore;
+
+    if (move.column != move.best)
+    {
+        // The root search would have given the played move this same score
+        board.DropCoin(move.column, player);
+        board.SetPlayerTurn(Opponent(player));
+
+        move.score = ScoreFor(player, AlphaBetaPlay(board, depth - 1, Opponent(player), context)[1]);
+    }
+
+    const int WIN = ConnectFourBoard::MAX_SCORE;
+
+    bool gaveUpWin = move.bestScore == WIN && move.score < WIN;
+    bool walkedIntoLoss = move.score == -WIN && move.bestScore > -WIN;
+    move.blunder = gaveUpWin || walkedIntoLoss || move.bestScore - move.score >= threshold;
+}
+
+int main(int argc, char** argv)
+{
+    const char* input = nullptr;
+    const char* output = nullptr;
+    int depth = 7;
+    int threadCount = (int)std::thread::hardware_concurrency();
+    int tableMegabytes = 64;
+    int threshold = 40;
+    Evaluation evaluation = Evaluation::PATTERNS;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if      (strcmp(argv[i], "--input") == 0 && i + 1 < argc)       input = argv[++i];
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)      output = argv[++i];
+        else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc)       depth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)     threadCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--table") == 0 && i + 1 < argc)       tableMegabytes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)   threshold = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--window-count") == 0)                evaluation = Evaluation::WINDOW_COUNT;
+        else
+        {
+            input = nullptr;
+            break;
+        }
+    }
+
+    if (!input)
+    {
+        fprintf(stderr, "Usage: %s --input file [--output file] [--depth N] [--threads N] [--table MB] [--threshold N] [--window-count]\n", argv[0]);
+        return 1;
+    }
+
+    if (depth < 1) depth = 1;
+    if (threadCount < 1) threadCount = 1;
+    if (tableMegabytes < 1) tableMegabytes = 1;
+    if (threshold < 1) threshold = 1;
+
+    FILE* games = fopen(input, "r");
+    if (!games)
+    {
+        fprintf(stderr, "Can't read %s\n", input);
+        return 1;
+    }
+
+    int gameCount, skippedGames;
+    std::vector<AnalyzedMove> moves = ReadGames(games, gameCount, skippedGames);
+    fclose(games);
+
+    FILE* results = output ? fopen(output, "w") : stdout;
+    if (!results)
+    {
+        fprintf(stderr, "Can't write %s\n", output);
+        return 1;
+    }
+
+    fprintf(stderr, "%i games, %i positions, searching to depth %i with %i thread(s)\n",
+        gameCount - skippedGames, (int)moves.size(), depth, threadCount);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // One table for all threads. The moves of a game are next to each other, so threads mostly search
+    // positions of the same games and find the table filled. The whole run is one search for the table,
+    // threads starting searches of their own would change the generation under each other.
+    TranspositionTable table(tableMegabytes);
+    table.NewSearch();
+
+    std::atomic<size_t> nextMove(0);
+    std::atomic<size_t> movesDone(0);
+
+    auto work = [&]()
+    {
+        while (true)
+        {
+            size_t index = nextMove++;
+            if (index >= moves.size()) return;
+
+            AnalyzeMove(moves[index], depth, evaluation, threshold, table);
+
+            size_t done = ++movesDone;
+            if (done % 1000 == 0) fprintf(stderr, "\r%i / %i", (int)done, (int)moves.size());
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++) threads.push_back(std::thread(work));
+    work();
+    for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+    int blunders[2] = { 0, 0 };
+
+    fprintf(results, "# game ply player column score best bestScore loss flag\n");
+    for (const AnalyzedMove& move : moves)
+    {
+        int player = move.ply % 2 + 1;
+        if (move.blunder) blunders[player - 1]++;
+
+        fprintf(results, "%i %i %i %i %i %i %i %i %s\n", move.game, move.ply, player, move.column, move.score,
+            move.best, move.bestScore, move.bestScore - move.score, move.blunder ? "blunder" : "-");
+    }
+
+    if (output) fclose(results);
+
+    fprintf(stderr, "\r%i positions in %.1fs, %.0f positions/s\n", (int)moves.size(), seconds,
+        seconds > 0 ? moves.size() / seconds : 0.0f);
+    fprintf(stderr, "Blunders: %i by the first player, %i by the second\n", blunders[0], blunders[1]);
+
+    return 0;
+}
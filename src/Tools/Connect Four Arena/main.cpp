@@ -0,0 +1,454 @@
+// Plays two engines against each other without a window and estimates how much stronger one is.
+//
+// Usage: "Connect Four Arena" --engine1 SPEC --engine2 SPEC [--games N] [--threads N] [--opening N]
+//                             [--table MB] [--seed N] [--output file] [--telemetry file]
+//
+// Engines:
+//  random              Any legal move
+//  minimax:DEPTH       MaximizePlay / MinimizePlay
+//  alphabeta:DEPTH     AlphaBetaPlay with a transposition table
+//  id:MILLISECONDS     IterativeDeepeningPlay with a time budget
+//  mcts:PLAYOUTS       MonteCarloPlay, one thread
+//
+// alphabeta and id score the boards with SimpleScoring, "+patterns" behind the setting switches them to
+// PatternScoring (alphabeta:6+patterns).
+//
+// The games go in pairs. Both games of a pair start from the same --opening random moves and the
+// engines swap who moves first, so a lucky opening counts for both. Every thread plays whole pairs with
+// its own tables. The result is engine 1's score, the Elo difference that score means with a 95%
+// confidence interval, and the games per second.
+//
+// --output writes one line per game, the columns played (0-6, first player first), the result for the
+// first player (1-0, 0-1 or 1/2) and the two engines. --telemetry writes one JSON line per move of the
+// alphabeta and id engines with the search statistics, see SearchStatistics::ToJson.
+//
+// Example, Monte Carlo against alpha-beta:
+//  "Connect Four Arena" --engine1 mcts:20000 --engine2 alphabeta:7 --games 400
+
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConnectFour.h"
+#include "ConnectFourAI.h"
+#include "ConnectFourMCTS.h"
+#include "TranspositionTable.h"
+
+enum class EngineType
+{
+    RANDOM,
+    MINIMAX,
+    ALPHA_BETA,
+    ITERATIVE_DEEPENING,
+    MONTE_CARLO,
+};
+
+struct EngineConfig
+{
+    EngineType type = EngineType::RANDOM;
+    int setting = 0; // Depth, milliseconds or playouts
+    Evaluation evaluation = Evaluation::WINDOW_COUNT;
+    std::string name;
+};
+
+// Same generator on every platform, so a seed plays the same openings everywhere
+struct Random
+{
+    uint64_t state;
+
+    explicit Random(uint64_t seed) : state(seed ? seed : 1) {}
+
+    uint64_t Next()
+    {
+        // xorshift64*
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+};
+
+bool ParseEngine(const char* text, EngineConfig& engine)
+{
+    engine.name = text;
+
+    if (strcmp(text, "random") == 0)
+    {
+        engine.type = EngineType::RANDOM;
+        return true;
+    }
+
+    const char* colon = strchr(text, ':');
+    if (!colon) return false;
+
+    std::string type(text, colon);
+    engine.setting = atoi(colon + 1);
+    if (engine.setting < 1) return false;
+
+    if      (type == "minimax")     engine.type = EngineType::MINIMAX;
+    else if (type == "alphabeta")   engine.type = EngineType::ALPHA_BETA;
+    else if (type == "id")          engine.type = EngineType::ITERATIVE_DEEPENING;
+    else if (type == "mcts")        engine.type = EngineType::MONTE_CARLO;
+    else return false;
+
+    const char* suffix = strchr(colon, '+');
+    if (suffix)
+    {
+        if (strcmp(suffix, "+patterns") != 0) return false;
+        if (engine.type != EngineType::ALPHA_BETA && engine.type != EngineType::ITERATIVE_DEEPENING) return false;
+
+        engine.evaluation = Evaluation::PATTERNS;
+    }
+
+    return true;
+}
+
+Player Opponent(Player player)
+{
+    return player == Player::AI ? Player::HUMAN : Player::AI;
+}
+
+int RandomMove(const ConnectFourBoard& board, Random& random)
+{
+    int legal[ConnectFourBoard::COLUMNS];
+    int count = 0;
+
+    for (int column = 0; column < ConnectFourBoard::COLUMNS; column++)
+    {
+        ConnectFourBoard child = board;
+        if (child.DropCoin(column, Player::HUMAN)) legal[count++] = column;
+    }
+
+    return count > 0 ? legal[random.Next() % count] : NIL;
+}
+
+// One engine as played by one thread, the table stays with it between moves of a game
+struct Engine
+{
+    EngineConfig config;
+
+    // Only for the engines that search with one
+    std::unique_ptr<TranspositionTable> table;
+
+    // Of the last move
+    SearchStatistics statistics;
+
+    Engine(const EngineConfig& config, int tableMegabytes)
+        : config(config)
+    {
+        if (config.type == EngineType::ALPHA_BETA || config.type == EngineType::ITERATIVE_DEEPENING)
+            table.reset(new TranspositionTable(tableMegabytes));
+    }
+
+    void NewGame()
+    {
+        if (table) table->Clear();
+    }
+
+    int Move(ConnectFourBoard& board, Player player, Random& random)
+    {
+        SearchContext context;
+        context.transpositionTable = table.get();
+        context.evaluation = config.evaluation;
+        if (table) table->NewSearch();
+
+        switch (config.type)
+        {
+        case EngineType::RANDOM:
+            return RandomMove(board, random);
+
+        case EngineType::MINIMAX:
+            // The board scores are always for the AI, the human minimizes them
+            return player == Player::AI ? MaximizePlay(board, config.setting, context.statistics)[0]
+                                        : MinimizePlay(board, config.setting, context.statistics)[0];
+
+        case EngineType::ALPHA_BETA:
+        {
+            int column = AlphaBetaPlay(board, config.setting, player, context)[0];
+            statistics = context.statistics;
+            return column;
+        }
+
+        case EngineType::ITERATIVE_DEEPENING:
+        {
+            int column = IterativeDeepeningPlay(board, player, ConnectFourBoard::ROWS * ConnectFourBoard::COLUMNS, (float)config.setting, context)[0];
+            statistics = context.statistics;
+            return column;
+        }
+
+        case EngineType::MONTE_CARLO:
+        {
+            MonteCarloSettings settings;
+            settings.iterations = config.setting;
+            return MonteCarloPlay(board, player, settings).column;
+        }
+        }
+
+        return NIL;
+    }
+};
+
+// 1 the first player won, -1 the second, 0 draw. With telemetry the searched moves are added to it as JSON lines.
+int PlayGame(Engine& first, Engine& second, const std::vector<int>& opening, Random& random, std::string& moves,
+    int gameIndex, std::string* telemetry)
+{
+    ConnectFourBoard board;
+    board.ResetBoard();
+
+    first.NewGame();
+    second.NewGame();
+
+    moves.clear();
+
+    // The first player is HUMAN on the board, it moves first in the game too
+    Player player = Player::HUMAN;
+
+    for (size_t i = 0; i < opening.size(); i++)
+    {
+        board.DropCoin(opening[i], player);
+        moves += char('0' + opening[i]);
+        player = Opponent(player);
+    }
+
+    while (!board.IsFinished())
+    {
+        board.SetPlayerTurn(player);
+
+        Engine& engine = player == Player::HUMAN ? first : second;
+        int column = engine.Move(board, player, random);
+
+        bool searched = engine.config.type == EngineType::ALPHA_BETA || engine.config.type == EngineType::ITERATIVE_DEEPENING;
+        if (telemetry && searched)
+        {
+            char line[256];
+            snprintf(line, sizeof(line), "{\"game\":%i,\"ply\":%i,\"engine\":\"%s\",\"column\":%i,\"search\":",
+                gameIndex, board.GetNumberOfMoves(), engine.config.name.c_str(), column);
+
+            *telemetry += line + engine.statistics.ToJson() + "}\n";
+        }
+
+        // A search that can't find a move forfeits, it never should
+        if (!board.DropCoin(column, player)) return player == Player::HUMAN ? -1 : 1;
+
+        moves += char('0' + column);
+
+        if (ConnectFourBoard::FourInARow(board.GetCoins(player))) return player == Player::HUMAN ? 1 : -1;
+
+        player = Opponent(player);
+    }
+
+    return 0;
+}
+
+// Random moves that don't finish the game, the same for both games of a pair
+std::vector<int> RandomOpening(int length, Random& random)
+{
+    while (true)
+    {
+        ConnectFourBoard board;
+        board.ResetBoard();
+
+        std::vector<int> opening;
+        Player player = Player::HUMAN;
+        bool decided = false;
+
+        for (int i = 0; i < length && !decided; i++)
+        {
+            int column = RandomMove(board, random);
+            board.DropCoin(column, player);
+            opening.push_back(column);
+
+            decided = ConnectFourBoard::FourInARow(board.GetCoins(player)) != 0;
+            player = Opponent(player);
+        }
+
+        if (!decided) return opening;
+    }
+}
+
+// The Elo difference that makes a player score this fraction of the points
+float EloDifference(float score)
+{
+    if (score <= 0.0f) return -INFINITY;
+    if (score >= 1.0f) return INFINITY;
+    return 400.0f * log10f(score / (1.0f - score));
+}
+
+int main(int argc, char** argv)
+{
+    EngineConfig engines[2];
+    bool haveEngine[2] = { false, false };
+    int gameCount = 200;
+    int threadCount = (int)std::thread::hardware_concurrency();
+    int openingLength = 4;
+    int tableMegabytes = 16;
+    uint64_t seed = 1;
+    const char* output = nullptr;
+    const char* telemetryOutput = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool valid = true;
+
+        if      (strcmp(argv[i], "--engine1") == 0 && i + 1 < argc) valid = haveEngine[0] = ParseEngine(argv[++i], engines[0]);
+        else if (strcmp(argv[i], "--engine2") == 0 && i + 1 < argc) valid = haveEngine[1] = ParseEngine(argv[++i], engines[1]);
+        else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc)   gameCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--opening") == 0 && i + 1 < argc) openingLength = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--table") == 0 && i + 1 < argc)   tableMegabytes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)    seed = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)  output = argv[++i];
+        else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) telemetryOutput = argv[++i];
+        else valid = false;
+
+        if (!valid)
+        {
+            fprintf(stderr, "Usage: %s --engine1 SPEC --engine2 SPEC [--games N] [--threads N] [--opening N] [--table MB] [--seed N] [--output file] [--telemetry file]\n", argv[0]);
+            fprintf(stderr, "SPEC: random, minimax:DEPTH, alphabeta:DEPTH, id:MILLISECONDS or mcts:PLAYOUTS\n");
+            fprintf(stderr, "      alphabeta and id take +patterns for PatternScoring\n");
+            return 1;
+        }
+    }
+
+    if (!haveEngine[0] || !haveEngine[1])
+    {
+        fprintf(stderr, "Both --engine1 and --engine2 are needed\n");
+        return 1;
+    }
+
+    // Whole pairs only
+    int pairCount = (gameCount + 1) / 2;
+    if (pairCount < 1) pairCount = 1;
+    if (threadCount < 1) threadCount = 1;
+    if (openingLength < 0) openingLength = 0;
+
+    // Long random openings are mostly decided already, and half a board is plenty of variety
+    if (openingLength > ConnectFourBoard::ROWS * ConnectFourBoard::COLUMNS / 2) openingLength = ConnectFourBoard::ROWS * ConnectFourBoard::COLUMNS / 2;
+    if (tableMegabytes < 1) tableMegabytes = 1;
+
+    FILE* records = nullptr;
+    if (output)
+    {
+        records = fopen(output, "w");
+        if (!records)
+        {
+            fprintf(stderr, "Can't write %s\n", output);
+            return 1;
+        }
+    }
+
+    FILE* telemetry = nullptr;
+    if (telemetryOutput)
+    {
+        telemetry = fopen(telemetryOutput, "w");
+        if (!telemetry)
+        {
+            fprintf(stderr, "Can't write %s\n", telemetryOutput);
+            return 1;
+        }
+    }
+
+    fprintf(stderr, "%s vs %s, %i games from %i random moves with %i thread(s)\n",
+        engines[0].name.c_str(), engines[1].name.c_str(), pairCount * 2, openingLength, threadCount);
+
+    // For engine 1
+    int wins = 0, draws = 0, losses = 0;
+    int firstPlayerWins = 0;
+
+    std::atomic<int> nextPair(0);
+    std::mutex mutex;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    auto work = [&]()
+    {
+        Engine engine1(engines[0], tableMegabytes);
+        Engine engine2(engines[1], tableMegabytes);
+
+        while (true)
+        {
+            int pair = nextPair++;
+            if (pair >= pairCount) return;
+
+            // Every pair has its own generator, the games don't depend on which thread plays them
+            Random random(seed * 0x9E3779B97F4A7C15ULL + (uint64_t)pair + 1);
+            std::vector<int> opening = RandomOpening(openingLength, random);
+
+            std::string moves[2];
+            std::string searches;
+            int results[2];
+            results[0] = PlayGame(engine1, engine2, opening, random, moves[0], pair * 2, telemetry ? &searches : nullptr);
+            results[1] = PlayGame(engine2, engine1, opening, random, moves[1], pair * 2 + 1, telemetry ? &searches : nullptr);
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (telemetry) fputs(searches.c_str(), telemetry);
+
+            for (int game = 0; game < 2; game++)
+            {
+                // Engine 1 moves first in the first game of the pair
+                int result = game == 0 ? results[game] : -results[game];
+
+                if (result > 0) wins++;
+                else if (result < 0) losses++;
+                else draws++;
+
+                if (results[game] > 0) firstPlayerWins++;
+
+                if (records)
+                {
+                    const char* outcome = results[game] > 0 ? "1-0" : results[game] < 0 ? "0-1" : "1/2";
+                    const EngineConfig& first = game == 0 ? engines[0] : engines[1];
+                    const EngineConfig& second = game == 0 ? engines[1] : engines[0];
+                    fprintf(records, "%s %s %s %s\n", moves[game].c_str(), outcome, first.name.c_str(), second.name.c_str());
+                }
+            }
+
+            int played = wins + draws + losses;
+            if (played % 20 == 0 || played == pairCount * 2)
+            {
+                fprintf(stderr, "\r%i / %i  +%i =%i -%i  ", played, pairCount * 2, wins, draws, losses);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++) threads.push_back(std::thread(work));
+    work();
+    for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+    fprintf(stderr, "\n");
+
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+    if (records) fclose(records);
+    if (telemetry) fclose(telemetry);
+
+    int games = wins + draws + losses;
+    float score = (wins + 0.5f * draws) / games;
+
+    // Spread of the points of a single game, the interval shrinks with the square root of the games
+    float variance = (wins * (1.0f - score) * (1.0f - score) + draws * (0.5f - score) * (0.5f - score) +
+        losses * score * score) / games;
+    float margin = 1.96f * sqrtf(variance / games);
+
+    float elo = EloDifference(score);
+    float eloLow = EloDifference(score - margin);
+    float eloHigh = EloDifference(score + margin);
+
+    printf("%s vs %s\n", engines[0].name.c_str(), engines[1].name.c_str());
+    printf("Games:        %i (+%i =%i -%i), the first player won %i\n", games, wins, draws, losses, firstPlayerWins);
+    printf("Score:        %.1f%% +- %.1f%%\n", score * 100.0f, margin * 100.0f);
+    printf("Elo:          %+.0f [%+.0f, %+.0f] (95%%)\n", elo, eloLow, eloHigh);
+    printf("Games/second: %.2f (%.1fs)\n", games / seconds, seconds);
+
+    return 0;
+}
@@ -0,0 +1,255 @@
+// Runs the Connect Four search over a fixed set of positions without a window, so the speed
+// of the engine can be compared between changes.
+//
+// Usage: "Connect Four Benchmark" [--depth N] [--threads N] [--table MB] [--no-heuristics] [--mirror] [--patterns]
+//                                 [--window full|aspiration|mtdf] [--aspiration N] [--json]
+//
+// Every position is searched one depth at a time up to --depth, like the game does with a time
+// budget, with a cleared transposition table. --json writes one line per position and one summary
+// line instead of the table, for scripts that look for regressions. --no-heuristics searches without
+// killer moves and history, to see what they save. --mirror lets mirror images share table entries.
+// --patterns scores the leaves with PatternScoring instead of SimpleScoring. --window picks the root
+// window (see SearchWindow), every one finds the same moves so the nodes show which gets there cheapest.
+// --aspiration is half the width of the first aspiration window. "Cut 1st" is the share of cutoffs by
+// the first move, "Roots" the root searches it took.
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "ConnectFour.h"
+#include "ConnectFourAI.h"
+#include "TranspositionTable.h"
+
+struct BenchmarkPosition
+{
+    const char* name;
+    const char* moves; // Columns played so far, the human starts
+};
+
+// Openings, middle games and positions close to the end, none of them decided yet
+const BenchmarkPosition positions[] =
+{
+    { "empty",          ""                      },
+    { "center",         "3"                     },
+    { "edge",           "0"                     },
+    { "opening 1",      "3342"                  },
+    { "opening 2",      "332455"                },
+    { "opening 3",      "23344"                 },
+    { "middle 1",       "3332224"               },
+    { "middle 2",       "334425611"             },
+    { "middle 3",       "0123456654"            },
+    { "middle 4",       "33332222444"           },
+    { "late 1",         "4130633320124513"      },
+    { "late 2",         "41435316225315251530"  },
+    { "late 3",         "404322233264523104644606" },
+};
+
+struct BenchmarkResult
+{
+    int depth = 0;
+    ColumnScore best = ColumnScore(NIL, 0);
+    long long nodes = 0;
+    long long cutoffs = 0;
+    long long firstMoveCutoffs = 0;
+    long long rootSearches = 0;
+    float milliseconds = 0;
+
+    // Milliseconds since the start of the position when every depth finished
+    std::vector<float> timeToDepth;
+};
+
+bool SetupPosition(const char* moves, ConnectFourBoard& board)
+{
+    board.ResetBoard();
+
+    Player player = Player::HUMAN;
+    for (const char* move = moves; *move; move++)
+    {
+        if (!board.DropCoin(*move - '0', player)) return false;
+        player = player == Player::HUMAN ? Player::AI : Player::HUMAN;
+    }
+
+    board.SetPlayerTurn(player);
+    return board.SimpleScoring() != ConnectFourBoard::MAX_SCORE && board.SimpleScoring() != -ConnectFourBoard::MAX_SCORE;
+}
+
+BenchmarkResult RunPosition(ConnectFourBoard& board, int maxDepth, int threadCount, bool useMoveHeuristics, bool useMirrorSymmetry,
+    Evaluation evaluation, SearchWindow window, int aspirationWindow, TranspositionTable& table)
+{
+    BenchmarkResult result;
+
+    table.Clear();
+    table.NewSearch();
+
+    SearchContext context;
+    context.transpositionTable = &table;
+    context.threadCount = threadCount;
+    context.useMoveHeuristics = useMoveHeuristics;
+    context.useMirrorSymmetry = useMirrorSymmetry;
+    context.evaluation = evaluation;
+    context.window = window;
+    context.aspirationWindow = aspirationWindow;
+
+    int emptyCells = ConnectFourBoard::ROWS * ConnectFourBoard::COLUMNS - board.GetNumberOfMoves();
+    if (maxDepth > emptyCells) maxDepth = emptyCells;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (int depth = 1; depth <= maxDepth; depth++)
+    {
+        result.best = AlphaBetaPlay(board, depth, board.GetPlayerTurn(), context);
+        result.depth = depth;
+        result.timeToDepth.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    result.nodes = context.statistics.nodes;
+    result.cutoffs = context.statistics.cutoffs;
+    result.firstMoveCutoffs = context.statistics.firstMoveCutoffs;
+    result.rootSearches = context.statistics.rootSearches;
+    result.milliseconds = result.timeToDepth.empty() ? 0.0f : result.timeToDepth.back();
+    return result;
+}
+
+float NodesPerSecond(long long nodes, float milliseconds)
+{
+    return milliseconds > 0 ? nodes / (milliseconds / 1000.0f) : 0.0f;
+}
+
+float FirstMoveCutoffRate(long long firstMoveCutoffs, long long cutoffs)
+{
+    return cutoffs > 0 ? (float)firstMoveCutoffs / cutoffs : 0.0f;
+}
+
+// --window names, in SearchWindow order
+const char* const WINDOW_NAMES[] = { "full", "aspiration", "mtdf" };
+
+bool ParseWindow(const char* name, SearchWindow& window)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        if (strcmp(name, WINDOW_NAMES[i]) == 0)
+        {
+            window = (SearchWindow)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    int maxDepth = 12;
+    int threadCount = 1;
+    int tableMegabytes = 64;
+    bool useMoveHeuristics = true;
+    bool useMirrorSymmetry = false;
+    Evaluation evaluation = Evaluation::WINDOW_COUNT;
+    SearchWindow window = SearchWindow::FULL;
+    int aspirationWindow = SearchContext().aspirationWindow;
+    bool json = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if      (strcmp(argv[i], "--depth") == 0 && i + 1 < argc)   maxDepth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--table") == 0 && i + 1 < argc)   tableMegabytes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--no-heuristics") == 0)           useMoveHeuristics = false;
+        else if (strcmp(argv[i], "--mirror") == 0)                  useMirrorSymmetry = true;
+        else if (strcmp(argv[i], "--patterns") == 0)                evaluation = Evaluation::PATTERNS;
+        else if (strcmp(argv[i], "--aspiration") == 0 && i + 1 < argc) aspirationWindow = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0)                    json = true;
+        else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc && ParseWindow(argv[i + 1], window)) i++;
+        else
+        {
+            fprintf(stderr, "Usage: %s [--depth N] [--threads N] [--table MB] [--no-heuristics] [--mirror] [--patterns] "
+                "[--window full|aspiration|mtdf] [--aspiration N] [--json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (maxDepth < 1) maxDepth = 1;
+    if (threadCount < 1) threadCount = 1;
+    if (tableMegabytes < 1) tableMegabytes = 1;
+    if (aspirationWindow < 1) aspirationWindow = 1;
+
+    TranspositionTable table(tableMegabytes);
+
+    if (!json)
+    {
+        printf("Depth %d, %d thread(s), %d MB table, move heuristics %s, mirroring %s, %s, %s", maxDepth, threadCount, tableMegabytes,
+            useMoveHeuristics ? "on" : "off", useMirrorSymmetry ? "on" : "off", evaluation == Evaluation::PATTERNS ? "patterns" : "window count",
+            GetSearchWindowName(window));
+        if (window == SearchWindow::ASPIRATION) printf(" +-%d", aspirationWindow);
+        printf("\n\n");
+        printf("%-12s %-24s %5s %4s %8s %12s %10s %12s %8s %6s\n", "Position", "Moves", "Depth", "Move", "Score", "Nodes", "ms", "Nodes/s", "Cut 1st", "Roots");
+    }
+
+    long long totalNodes = 0;
+    long long totalCutoffs = 0;
+    long long totalFirstMoveCutoffs = 0;
+    long long totalRootSearches = 0;
+    float totalMilliseconds = 0;
+
+    for (const BenchmarkPosition& position : positions)
+    {
+        ConnectFourBoard board;
+        if (!SetupPosition(position.moves, board))
+        {
+            fprintf(stderr, "Position \"%s\" (%s) is not playable\n", position.name, position.moves);
+            return 1;
+        }
+
+        BenchmarkResult result = RunPosition(board, maxDepth, threadCount, useMoveHeuristics, useMirrorSymmetry, evaluation,
+            window, aspirationWindow, table);
+        totalNodes += result.nodes;
+        totalCutoffs += result.cutoffs;
+        totalFirstMoveCutoffs += result.firstMoveCutoffs;
+        totalRootSearches += result.rootSearches;
+        totalMilliseconds += result.milliseconds;
+
+        float nodesPerSecond = NodesPerSecond(result.nodes, result.milliseconds);
+        float firstMoveCutoffRate = FirstMoveCutoffRate(result.firstMoveCutoffs, result.cutoffs);
+
+        if (json)
+        {
+            printf("{\"position\":\"%s\",\"moves\":\"%s\",\"depth\":%d,\"move\":%d,\"score\":%d,\"nodes\":%lld,\"ms\":%.3f,\"nodesPerSecond\":%.0f,\"firstMoveCutoffRate\":%.4f,\"rootSearches\":%lld,\"timeToDepth\":[",
+                position.name, position.moves, result.depth, result.best[0], result.best[1], result.nodes, result.milliseconds, nodesPerSecond, firstMoveCutoffRate,
+                result.rootSearches);
+
+            for (size_t i = 0; i < result.timeToDepth.size(); i++)
+                printf(i == 0 ? "%.3f" : ",%.3f", result.timeToDepth[i]);
+
+            printf("]}\n");
+        }
+        else
+        {
+            printf("%-12s %-24s %5d %4d %8d %12lld %10.1f %12.0f %7.1f%% %6lld\n",
+                position.name, position.moves, result.depth, result.best[0], result.best[1], result.nodes, result.milliseconds, nodesPerSecond, firstMoveCutoffRate * 100.0f,
+                result.rootSearches);
+        }
+
+        fflush(stdout);
+    }
+
+    float nodesPerSecond = NodesPerSecond(totalNodes, totalMilliseconds);
+    float firstMoveCutoffRate = FirstMoveCutoffRate(totalFirstMoveCutoffs, totalCutoffs);
+
+    if (json)
+    {
+        printf("{\"summary\":true,\"depth\":%d,\"threads\":%d,\"tableMB\":%d,\"moveHeuristics\":%s,\"mirror\":%s,\"patterns\":%s,\"window\":\"%s\",\"aspiration\":%d,\"nodes\":%lld,\"ms\":%.3f,\"nodesPerSecond\":%.0f,\"firstMoveCutoffRate\":%.4f,\"rootSearches\":%lld}\n",
+            maxDepth, threadCount, tableMegabytes, useMoveHeuristics ? "true" : "false", useMirrorSymmetry ? "true" : "false",
+            evaluation == Evaluation::PATTERNS ? "true" : "false", WINDOW_NAMES[(int)window], aspirationWindow, totalNodes, totalMilliseconds, nodesPerSecond,
+            firstMoveCutoffRate, totalRootSearches);
+    }
+    else
+    {
+        printf("\n%-12s %-24s %5s %4s %8s %12lld %10.1f %12.0f %7.1f%% %6lld\n", "Total", "", "", "", "", totalNodes, totalMilliseconds, nodesPerSecond,
+            firstMoveCutoffRate * 100.0f, totalRootSearches);
+    }
+
+    return 0;
+}
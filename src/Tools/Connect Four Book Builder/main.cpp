@@ -0,0 +1,193 @@
+// Searches every position of the first moves and writes the results to an opening book the game
+// memory maps, see OpeningBook.h.
+//
+// Usage: "Connect Four Book Builder" [--ply N] [--depth N] [--threads N] [--table MB] [--patterns] [--output file]
+//
+// Every position with up to --ply coins (both players to move, games that are already won left out)
+// is searched with alpha-beta to --depth. --patterns searches with PatternScoring instead of SimpleScoring,
+// the game only uses a book of the evaluation it plays with. Copy the output next to the game's Images folder.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "ConnectFour.h"
+#include "ConnectFourAI.h"
+#include "OpeningBook.h"
+#include "TranspositionTable.h"
+
+struct BookPosition
+{
+    ConnectFourBoard board;
+    Player player;
+};
+
+// Every position reachable in up to maxPly moves, the human starts
+std::vector<BookPosition> CollectPositions(int maxPly)
+{
+    std::vector<BookPosition> positions;
+    std::vector<BookPosition> ply;
+    std::unordered_set<uint64_t> seen;
+
+    BookPosition start;
+    start.board.ResetBoard();
+    start.player = Player::HUMAN;
+    ply.push_back(start);
+
+    for (int moves = 0; moves <= maxPly; moves++)
+    {
+        positions.insert(positions.end(), ply.begin(), ply.end());
+        if (moves == maxPly) break;
+
+        std::vector<BookPosition> nextPly;
+        for (BookPosition& position : ply)
+        {
+            Player opponent = position.player == Player::AI ? Player::HUMAN : Player::AI;
+
+            for (int column = 0; column < ConnectFourBoard::COLUMNS; column++)
+            {
+                BookPosition next = position;
+                if (!next.board.DropCoin(column, position.player)) continue;
+
+                // The game is over, nothing to look up
+                if (ConnectFourBoard::FourInARow(next.board.GetCoins(position.player))) continue;
+
+                next.player = opponent;
+                next.board.SetPlayerTurn(opponent);
+
+                // Different move orders reach the same position
+                if (!seen.insert(OpeningBook::GetKey(next.board, next.player)).second) continue;
+
+                nextPly.push_back(next);
+            }
+        }
+
+        ply.swap(nextPly);
+    }
+
+    return positions;
+}
+
+int main(int argc, char** argv)
+{
+    int maxPly = 4;
+    int depth = 12;
+    int threadCount = (int)std::thread::hardware_concurrency();
+    int tableMegabytes = 256;
+    Evaluation evaluation = Evaluation::WINDOW_COUNT;
+    const char* output = "OpeningBook.bin";
+
+    for (int i = 1; i < argc; i++)
+    {
+        if      (strcmp(argv[i], "--ply") == 0 && i + 1 < argc)     maxPly = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc)   depth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--table") == 0 && i + 1 < argc)   tableMegabytes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--patterns") == 0)                evaluation = Evaluation::PATTERNS;
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)  output = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--ply N] [--depth N] [--threads N] [--table MB] [--patterns] [--output file]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (maxPly < 0) maxPly = 0;
+    if (depth < 1) depth = 1;
+    if (threadCount < 1) threadCount = 1;
+    if (tableMegabytes < 1) tableMegabytes = 1;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<BookPosition> positions = CollectPositions(maxPly);
+    std::vector<OpeningBookEntry> entries(positions.size());
+
+    fprintf(stderr, "%i positions up to ply %i, searching to depth %i with %i thread(s), %s\n",
+        (int)positions.size(), maxPly, depth, threadCount, evaluation == Evaluation::PATTERNS ? "patterns" : "window count");
+
+    // One table for all threads, neighbouring positions share most of their search
+    TranspositionTable table(tableMegabytes);
+
+    std::atomic<size_t> nextPosition(0);
+    std::atomic<size_t> positionsDone(0);
+    std::mutex printMutex;
+
+    auto work = [&]()
+    {
+        while (true)
+        {
+            size_t index = nextPosition++;
+            if (index >= positions.size()) return;
+
+            BookPosition& position = positions[index];
+
+            SearchContext context;
+            context.transpositionTable = &table;
+            context.evaluation = evaluation;
+
+            ColumnScore move = AlphaBetaPlay(position.board, depth, position.player, context);
+
+            OpeningBookEntry& entry = entries[index];
+            memset(&entry, 0, sizeof(entry));
+            entry.key = OpeningBook::GetKey(position.board, position.player);
+            entry.score = move[1];
+            entry.column = (int8_t)move[0];
+
+            size_t done = ++positionsDone;
+            if (done % 100 == 0 || done == positions.size())
+            {
+                std::lock_guard<std::mutex> lock(printMutex);
+                fprintf(stderr, "\r%i / %i", (int)done, (int)positions.size());
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++) threads.push_back(std::thread(work));
+    work();
+    for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+    fprintf(stderr, "\n");
+
+    std::sort(entries.begin(), entries.end(),
+        [](const OpeningBookEntry& a, const OpeningBookEntry& b) { return a.key < b.key; });
+
+    OpeningBookHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "C4BK", 4);
+    header.version = OpeningBook::VERSION;
+    header.entryCount = (uint32_t)entries.size();
+    header.maxPly = (uint32_t)maxPly;
+    header.depth = (uint32_t)depth;
+    header.evaluation = (uint32_t)evaluation;
+
+    FILE* file = fopen(output, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Can't write %s\n", output);
+        return 1;
+    }
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(entries.data(), sizeof(OpeningBookEntry), entries.size(), file) == entries.size();
+    written = fclose(file) == 0 && written;
+
+    if (!written)
+    {
+        fprintf(stderr, "Can't write %s\n", output);
+        return 1;
+    }
+
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    printf("Wrote %i entries (%i bytes) to %s in %.1fs\n", (int)entries.size(),
+        (int)(sizeof(header) + entries.size() * sizeof(OpeningBookEntry)), output, seconds);
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#ifndef AI_WORKER_H
+#define AI_WORKER_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+
+// Runs one AI decision at a time on a thread of its own, so the window keeps drawing while the AI thinks.
+//
+//  worker.Start(job);                  // Render thread, returns right away
+//  ...
+//  if (worker.Poll(result)) ...        // Every frame, true once the job is done
+//
+// The job gets a flag that turns true when the decision is no longer wanted, searches given the flag
+// stop soon after.
+template <typename Result>
+class AIWorker
+{
+public:
+    typedef std::function<Result(const std::atomic<bool>& cancelled)> Job;
+
+    ~AIWorker()
+    {
+        Cancel();
+    }
+
+    // Cancels the job that is still running, if any, and starts this one
+    void Start(Job job)
+    {
+        Cancel();
+
+        std::shared_ptr<std::atomic<bool>> flag = std::make_shared<std::atomic<bool>>(false);
+        cancelled = flag;
+        result = std::async(std::launch::async, [job, flag]() { return job(*flag); });
+    }
+
+    // True once a job was started and hasn't been picked up by Poll yet
+    bool IsBusy() const
+    {
+        return result.valid();
+    }
+
+    // Fills the result of the job when it is done and returns true, once
+    bool Poll(Result& value)
+    {
+        if (!result.valid() || result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+
+        value = result.get();
+        cancelled.reset();
+        return true;
+    }
+
+    // Stops the running job and throws away its result. Waits for the job to notice,
+    // which searches that check the flag do within a few thousand nodes.
+    void Cancel()
+    {
+        if (cancelled) cancelled->store(true);
+        if (result.valid()) result.wait();
+
+        result = std::future<Result>();
+        cancelled.reset();
+    }
+
+private:
+    std::future<Result> result;
+    std::shared_ptr<std::atomic<bool>> cancelled;
+};
+
+#endif
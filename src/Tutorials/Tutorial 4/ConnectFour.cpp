@@ -1,123 +1,599 @@
 #include "ConnectFour.h"
 
-#include <SOIL.h>
-#include <string>
-#include <GLFW/glfw3.h> // GLFW helper library
+#include <type_traits>
+#include <vector>
 
-using namespace glm;
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
-ConnectFourBoard::ConnectFourBoard()
-{
-}
+// AVX2 has a shift count per 64 bit lane, so all four directions of a board fit in one register.
+// It needs /arch:AVX2 or -mavx2, without it the directions are done one after the other.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CONNECT_FOUR_AVX2
+#endif
 
-void ConnectFourBoard::InitializeBoard()
+namespace
 {
-    ResetBoard();
+    // A winning window, kept with the arguments ScorePosition expects for it
+    struct ScoringWindow
+    {
+        Bitboard mask = 0;
+        int row = 0, column = 0, delta_y = 0, delta_x = 0;
+    };
 
-    for (int i = 0; i < 4; i++)
+    // Same as CellBit, but usable while the table is built by the compiler
+    template <class Board>
+    constexpr int CellIndex(int row, int column)
     {
-        std::string coinLocation = std::string(ASSETS) + std::string("Images/Coin") +
-            std::to_string(i) + std::string(".png");
-
-        coinTexture[i] = SOIL_load_OGL_texture(
-            coinLocation.c_str(),
-            SOIL_LOAD_AUTO,
-            SOIL_CREATE_NEW_ID,
-            SOIL_FLAG_INVERT_Y | SOIL_FLAG_NTSC_SAFE_RGB | SOIL_FLAG_COMPRESS_TO_DXT
-        );
-
-        glBindTexture(GL_TEXTURE_2D, coinTexture[i]);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        return column * Board::COLUMN_HEIGHT + (Board::ROWS - 1 - row);
     }
 
-    background = SOIL_load_OGL_texture(
-        ASSETS"Images/Background.png",
-        SOIL_LOAD_AUTO,
-        SOIL_CREATE_NEW_ID,
-        SOIL_FLAG_INVERT_Y | SOIL_FLAG_NTSC_SAFE_RGB | SOIL_FLAG_COMPRESS_TO_DXT
-    );
+    // Every window of the board, built at compile time so scoring never has to set anything up
+    template <class Board>
+    struct ScoringWindowTable
+    {
+        ScoringWindow windows[Board::WINDOW_COUNT] = {};
+        int count = 0;
 
-    glBindTexture(GL_TEXTURE_2D, background);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-}
+        // How many windows every bit of the board is part of, at most WIN_LENGTH per direction
+        int windowsThroughCell[64] = {};
 
-void ConnectFourBoard::ResetBoard()
-{
-    for (int i = 0; i < COLUMNS; i++)
+        constexpr void Add(int row, int column, int delta_y, int delta_x)
+        {
+            ScoringWindow& window = windows[count++];
+            window.mask = 0;
+            window.row = row;
+            window.column = column;
+            window.delta_y = delta_y;
+            window.delta_x = delta_x;
+
+            for (int i = 0; i < Board::WIN_LENGTH; i++)
+            {
+                int index = CellIndex<Board>(row + delta_y * i, column + delta_x * i);
+                window.mask |= Bitboard(1) << index;
+                windowsThroughCell[index]++;
+            }
+        }
+
+        constexpr ScoringWindowTable()
+        {
+            const int ROWS = Board::ROWS;
+            const int COLUMNS = Board::COLUMNS;
+
+            // First cell a window can start on and still fit, 3 with four in a row
+            const int LAST = Board::WIN_LENGTH - 1;
+
+            // Vertical windows
+            //
+            // Possible situations
+            //  0  1  2  3  4  5  6
+            // [x][ ][ ][ ][ ][ ][ ] 0
+            // [x][x][ ][ ][ ][ ][ ] 1
+            // [x][x][x][ ][ ][ ][ ] 2
+            // [x][x][x][ ][ ][ ][ ] 3
+            // [ ][x][x][ ][ ][ ][ ] 4
+            // [ ][ ][x][ ][ ][ ][ ] 5
+            for (int row = 0; row < ROWS - LAST; row++)
+                for (int column = 0; column < COLUMNS; column++)
+                    Add(row, column, 1, 0);
+
+            // Horizontal windows
+            //
+            // Possible situations
+            //  0  1  2  3  4  5  6
+            // [x][x][x][x][ ][ ][ ] 0
+            // [ ][x][x][x][x][ ][ ] 1
+            // [ ][ ][x][x][x][x][ ] 2
+            // [ ][ ][ ][x][x][x][x] 3
+            // [ ][ ][ ][ ][ ][ ][ ] 4
+            // [ ][ ][ ][ ][ ][ ][ ] 5
+            for (int row = 0; row < ROWS; row++)
+                for (int column = 0; column < COLUMNS - LAST; column++)
+                    Add(row, column, 0, 1);
+
+            // Diagonal windows 1 (left-bottom)
+            //
+            // Possible situation
+            //  0  1  2  3  4  5  6
+            // [x][ ][ ][x][ ][ ][ ] 0
+            // [ ][x][ ][ ][x][ ][ ] 1
+            // [x][ ][x][ ][ ][x][ ] 2
+            // [ ][x][ ][x][ ][ ][x] 3
+            // [ ][ ][x][ ][ ][ ][ ] 4
+            // [ ][ ][ ][x][ ][ ][ ] 5
+            for (int row = 0; row < ROWS - LAST; row++)
+                for (int column = 0; column < COLUMNS - LAST; column++)
+                    Add(row, column, 1, 1);
+
+            // Diagonal windows 2 (right-bottom)
+            //
+            // Possible situation
+            //  0  1  2  3  4  5  6
+            // [ ][ ][ ][x][ ][ ][ ] 0
+            // [ ][ ][x][ ][ ][ ][ ] 1
+            // [ ][x][ ][ ][ ][ ][x] 2
+            // [x][ ][ ][ ][ ][x][ ] 3
+            // [ ][ ][ ][ ][x][ ][ ] 4
+            // [ ][ ][ ][x][ ][ ][ ] 5
+            for (int row = 0; row < ROWS - LAST; row++)
+                for (int column = LAST; column < COLUMNS; column++)
+                    Add(row, column, 1, -1);
+        }
+    };
+
+    template <class Board>
+    constexpr ScoringWindowTable<Board> SCORING_WINDOWS{};
+
+    // A line of coins along one direction, twice as long every step. The length is known to
+    // the compiler, the loop disappears.
+    //
+    // 1 -> 2 -> 4 (-> 5 for connect five, the last step only needs to cover the rest)
+    template <int WinLength>
+    inline Bitboard LineInDirection(Bitboard coins, int shift)
     {
-        for (int j = 0; j < ROWS; j++)
+        Bitboard line = coins;
+        int length = 1;
+
+        for (; length * 2 <= WinLength; length *= 2) line &= line >> (length * shift);
+        if (length < WinLength) line &= line >> ((WinLength - length) * shift);
+
+        return line;
+    }
+
+    // The same bit operations on one direction or on a register with all four
+    inline Bitboard ShiftLeft(Bitboard lanes, int shift) { return lanes << shift; }
+    inline Bitboard ShiftRight(Bitboard lanes, int shift) { return lanes >> shift; }
+    inline Bitboard And(Bitboard a, Bitboard b) { return a & b; }
+    inline Bitboard Or(Bitboard a, Bitboard b) { return a | b; }
+    inline int Add(int a, int b) { return a + b; }
+
+#ifdef CONNECT_FOUR_AVX2
+    inline __m256i ShiftLeft(__m256i lanes, __m256i shifts) { return _mm256_sllv_epi64(lanes, shifts); }
+    inline __m256i ShiftRight(__m256i lanes, __m256i shifts) { return _mm256_srlv_epi64(lanes, shifts); }
+    inline __m256i And(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+    inline __m256i Or(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+    inline __m256i Add(__m256i a, __m256i b) { return _mm256_add_epi64(a, b); }
+#endif
+
+    // Cells where one more coin completes a line along the direction, filled or not
+    //
+    // x: the cell, with WinLength 4
+    // [c][c][c][x]  [c][c][x][c]  [c][x][c][c]  [x][c][c][c]
+    template <int WinLength, class Boards, class Shifts>
+    inline Boards CompletingCellsInDirection(Boards coins, Shifts shift)
+    {
+        // Cells with i coins in a row right below them (lower bits) and right above them
+        Boards below[WinLength];
+        Boards above[WinLength];
+
+        Shifts distance = shift;
+        below[1] = ShiftLeft(coins, distance);
+        above[1] = ShiftRight(coins, distance);
+
+        for (int i = 2; i < WinLength; i++)
         {
-            playingField[j][i] = '0'; // Reset the board here
+            distance = Add(distance, shift);
+            below[i] = And(below[i - 1], ShiftLeft(coins, distance));
+            above[i] = And(above[i - 1], ShiftRight(coins, distance));
         }
+
+        Boards cells = Or(below[WinLength - 1], above[WinLength - 1]);
+        for (int i = 1; i < WinLength - 1; i++) cells = Or(cells, And(below[i], above[WinLength - 1 - i]));
+
+        return cells;
     }
 
-    fallingTokens.clear();
+    // All four directions of the board
+    template <class Board>
+    inline Bitboard CompletingCells(Bitboard coins)
+    {
+        const int W = Board::WIN_LENGTH;
+        const int H = Board::COLUMN_HEIGHT;
+
+#ifdef CONNECT_FOUR_AVX2
+        // Vertical, horizontal, diagonal 1 and diagonal 2 side by side, then the lanes are or'ed together
+        __m256i lanes = CompletingCellsInDirection<W>(_mm256_set1_epi64x((long long)coins), _mm256_setr_epi64x(1, H, H - 1, H + 1));
+        __m128i half = _mm_or_si128(_mm256_castsi256_si128(lanes), _mm256_extracti128_si256(lanes, 1));
+        return (Bitboard)_mm_cvtsi128_si64(_mm_or_si128(half, _mm_unpackhi_epi64(half, half)));
+#else
+        return CompletingCellsInDirection<W>(coins, 1) | CompletingCellsInDirection<W>(coins, H) |
+            CompletingCellsInDirection<W>(coins, H - 1) | CompletingCellsInDirection<W>(coins, H + 1);
+#endif
+    }
 
-    numberOfMoves = 0;
-    currentTurn = Player::HUMAN;
-}
+    // The lowest cell of every column, adding it to the height mask gives the first free cells
+    template <class Board>
+    constexpr Bitboard BottomRow()
+    {
+        Bitboard row = 0;
+        for (int column = 0; column < Board::COLUMNS; column++) row |= Bitboard(1) << (column * Board::COLUMN_HEIGHT);
+        return row;
+    }
 
-bool ConnectFourBoard::DropCoin(int column, Player whichPlayer)
-{
-    if (playingField[0][column] == '0' && column >= 0 && column < COLUMNS)
+    // Every cell of the board without the spare bits
+    template <class Board>
+    constexpr Bitboard BoardMask()
+    {
+        return BottomRow<Board>() * ((Bitboard(1) << Board::ROWS) - 1);
+    }
+
+    // Windows through the cell of a single bit
+    template <class Board>
+    inline int WindowsThroughCell(Bitboard cell)
+    {
+        return SCORING_WINDOWS<Board>.windowsThroughCell[Board::CountCoins(cell - 1)];
+    }
+
+    constexpr int Power3(int exponent)
     {
-        for (int i = ROWS - 1; i >= 0; i--)
+        return exponent == 0 ? 1 : 3 * Power3(exponent - 1);
+    }
+
+    // The score of every window PatternScoring can come across. A window is a base-3 number with one digit
+    // per cell, the first cell lowest: 0 empty, 1 AI, 2 human. 81 windows with four in a row.
+    //
+    //  [ ][AI][ ][H]  ->  0 + 1*3 + 0*9 + 2*27 = 57
+    //
+    // Only windows a single player has coins in can still be won, and every coin counts four times the
+    // one before it.
+    template <class Board>
+    struct WindowPatternTable
+    {
+        int scores[Power3(Board::WIN_LENGTH)] = {};
+
+        constexpr WindowPatternTable()
         {
-            if (playingField[i][column] == '0')
+            for (int index = 0; index < Power3(Board::WIN_LENGTH); index++)
             {
-                playingField[i][column] = whichPlayer == Player::HUMAN ? '1' : '2';
-                fallingTokens.push_back(glm::vec4(i, column, glfwGetTime(), whichPlayer == Player::HUMAN ? 0.0f : 1.0f));
-                numberOfMoves += 1;
-                return true;
+                int ai = 0, human = 0;
+                for (int cell = 0, digits = index; cell < Board::WIN_LENGTH; cell++, digits /= 3)
+                {
+                    if (digits % 3 == 1) ai++;
+                    if (digits % 3 == 2) human++;
+                }
+
+                if (ai > 0 && human == 0) scores[index] = 1 << (2 * (ai - 1));
+                if (human > 0 && ai == 0) scores[index] = -(1 << (2 * (human - 1)));
             }
         }
+    };
+
+    template <class Board>
+    constexpr WindowPatternTable<Board> WINDOW_PATTERNS{};
+
+    // A window one coin short of a line is a threat on its empty cell. The player that moves first (always
+    // the human) can usually force the odd rows counted from the bottom, the other player the even rows,
+    // so a threat on the right row is worth this much more.
+    const int THREAT_ROW_BONUS = 8;
+
+    // PatternScoring doesn't look at the windows one by one, it looks at whole lines of the board (a row,
+    // a column or a diagonal) the same way: the line's cells as a base-3 number, looked up in a table with
+    // the scores of all windows on the line added up. Dropping a coin changes four lines, one per direction.
+    //
+    //  Line along a row, every COLUMN_HEIGHT bits:
+    //  [ ][ ][AI][H][ ][ ][ ]  ->  index 0..2186, windows 0-3, 1-4, 2-5 and 3-6 in one look up
+    struct PatternLine
+    {
+        // The line's bits are start, start + stride, ... as many as length
+        int start = 0, stride = 0, length = 0;
+
+        // Collects the line's bits next to each other, see GatherLine
+        Bitboard mask = 0, magic = 0;
+        int gatherShift = 0;
+
+        // Where the line's table starts in PatternLineTable::scores
+        int offset = 0;
+    };
+
+    // Each bit of the line times its own power of two of the magic lands right next to the bit before it.
+    // All other products land on bits of their own below those, so nothing carries into them.
+    inline int GatherLine(Bitboard coins, const PatternLine& line)
+    {
+        return (int)(((coins >> line.start) & line.mask) * line.magic >> line.gatherShift) & ((1 << line.length) - 1);
     }
 
-    // Couldn't drop a coin. Maybe it is full
-    return false;
+    template <class Board>
+    struct PatternLineTable
+    {
+        static_assert(Board::COLUMNS <= Board::COLUMN_HEIGHT, "A row has to be gathered without carries");
+        static_assert(Board::ROWS <= 8 && Board::COLUMNS <= 8, "Lines are looked up with a byte");
+
+        // One line starts on every cell of the left column and the bottom or top row, per direction
+        PatternLine lines[4 * (Board::ROWS + Board::COLUMNS)];
+        int lineCount = 0;
+
+        // Per bit of the board and direction, the line through the cell (-1 when it's too short
+        // for a window) and the position of the cell on it
+        int8_t lineThroughCell[64][4];
+        int8_t positionOnLine[64][4];
+
+        // Bits of a gathered line as base-3 digits of 1
+        int base3[256];
+        int power3[8];
+
+        std::vector<int16_t> scores;
+
+        PatternLineTable()
+        {
+            const int H = Board::COLUMN_HEIGHT;
+
+            for (int i = 0; i < 8; i++) power3[i] = Power3(i);
+            for (int bits = 0; bits < 256; bits++)
+            {
+                base3[bits] = 0;
+                for (int i = 0; i < 8; i++) if (bits & (1 << i)) base3[bits] += power3[i];
+            }
+
+            for (int cell = 0; cell < 64; cell++)
+                for (int direction = 0; direction < 4; direction++) lineThroughCell[cell][direction] = -1;
+
+            // Vertical, horizontal and the two diagonals, as column and row (from the bottom) steps
+            const int steps[4][2] = { { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 } };
+
+            for (int direction = 0; direction < 4; direction++)
+            {
+                int dc = steps[direction][0], dr = steps[direction][1];
+
+                for (int column = 0; column < Board::COLUMNS; column++)
+                    for (int row = 0; row < Board::ROWS; row++)
+                    {
+                        // Lines start on cells without a neighbour before them
+                        int c = column - dc, r = row - dr;
+                        if (c >= 0 && c < Board::COLUMNS && r >= 0 && r < Board::ROWS) continue;
+
+                        int length = 0;
+                        for (c = column, r = row; c < Board::COLUMNS && r >= 0 && r < Board::ROWS; c += dc, r += dr) length++;
+                        if (length < Board::WIN_LENGTH) continue;
+
+                        AddLine(direction, column * H + row, dc * H + dr, length);
+                    }
+            }
+        }
+
+        void AddLine(int direction, int start, int stride, int length)
+        {
+            PatternLine& line = lines[lineCount];
+            line.start = start;
+            line.stride = stride;
+            line.length = length;
+            line.offset = (int)scores.size();
+
+            for (int i = 0; i < length; i++)
+            {
+                line.mask |= Bitboard(1) << (i * stride);
+                line.magic |= Bitboard(1) << ((length - 1 - i) * (stride - 1));
+
+                lineThroughCell[start + i * stride][direction] = (int8_t)lineCount;
+                positionOnLine[start + i * stride][direction] = (int8_t)i;
+            }
+            line.gatherShift = (length - 1) * (stride - 1);
+
+            const int W = Board::WIN_LENGTH;
+
+            for (int index = 0; index < Power3(length); index++)
+            {
+                int score = 0;
+
+                for (int first = 0; first + W <= length; first++)
+                {
+                    int window = index / Power3(first) % Power3(W);
+                    score += WINDOW_PATTERNS<Board>.scores[window];
+
+                    int ai = 0, human = 0, empty = 0;
+                    for (int i = 0; i < W; i++)
+                    {
+                        int digit = window / Power3(i) % 3;
+                        if (digit == 1) ai++;
+                        if (digit == 2) human++;
+                        if (digit == 0) empty = first + i;
+                    }
+
+                    // Rows counted from 1 at the bottom
+                    bool oddRow = (start + empty * stride) % Board::COLUMN_HEIGHT % 2 == 0;
+
+                    if (ai == W - 1 && human == 0 && !oddRow) score += THREAT_ROW_BONUS;
+                    if (human == W - 1 && ai == 0 && oddRow) score -= THREAT_ROW_BONUS;
+                }
+
+                scores.push_back((int16_t)score);
+            }
+
+            lineCount++;
+        }
+
+        int LineIndex(const Bitboard coins[2], const PatternLine& line) const
+        {
+            return base3[GatherLine(coins[Player::AI], line)] + 2 * base3[GatherLine(coins[Player::HUMAN], line)];
+        }
+    };
+
+    // Built the first time a board of the size is scored this way
+    template <class Board>
+    const PatternLineTable<Board>& GetPatternLines()
+    {
+        static const PatternLineTable<Board> table;
+        return table;
+    }
+}
+
+template <int Rows, int Columns, int WinLength>
+BasicConnectFourBoard<Rows, Columns, WinLength>::BasicConnectFourBoard()
+{
+    coins[Player::HUMAN] = 0;
+    coins[Player::AI] = 0;
+    aiWindowPoints = 0;
+    numberOfMoves = 0;
+    currentTurn = Player::HUMAN;
+}
+
+// Bit layout, bit 0 is the bottom of column 0 and every column has a spare bit on top
+//
+//  0  1  2  3  4  5  6
+// [ 6][13][20][27][34][41][48] <- spare
+// [ 5][12][19][26][33][40][47] 0
+// [ 4][11][18][25][32][39][46] 1
+// [ 3][10][17][24][31][38][45] 2
+// [ 2][ 9][16][23][30][37][44] 3
+// [ 1][ 8][15][22][29][36][43] 4
+// [ 0][ 7][14][21][28][35][42] 5
+template <int Rows, int Columns, int WinLength>
+Bitboard BasicConnectFourBoard<Rows, Columns, WinLength>::CellBit(int row, int column)
+{
+    return Bitboard(1) << CellIndex<BasicConnectFourBoard>(row, column);
+}
+
+template <int Rows, int Columns, int WinLength>
+Bitboard BasicConnectFourBoard<Rows, Columns, WinLength>::BottomMask(int column)
+{
+    return Bitboard(1) << (column * COLUMN_HEIGHT);
+}
+
+template <int Rows, int Columns, int WinLength>
+Bitboard BasicConnectFourBoard<Rows, Columns, WinLength>::ColumnMask(int column)
+{
+    return ((Bitboard(1) << ROWS) - 1) << (column * COLUMN_HEIGHT);
 }
 
-Player ConnectFourBoard::GetPlayerTurn()
+template <int Rows, int Columns, int WinLength>
+Bitboard BasicConnectFourBoard<Rows, Columns, WinLength>::FourInARow(Bitboard coins)
+{
+    Bitboard result = 0;
+
+    // Vertical
+    result |= LineInDirection<WIN_LENGTH>(coins, 1);
+
+    // Horizontal
+    result |= LineInDirection<WIN_LENGTH>(coins, COLUMN_HEIGHT);
+
+    // Diagonal 1 (left-bottom)
+    result |= LineInDirection<WIN_LENGTH>(coins, COLUMN_HEIGHT - 1);
+
+    // Diagonal 2 (right-bottom)
+    result |= LineInDirection<WIN_LENGTH>(coins, COLUMN_HEIGHT + 1);
+
+    return result;
+}
+
+template <int Rows, int Columns, int WinLength>
+int BasicConnectFourBoard<Rows, Columns, WinLength>::CountCoins(Bitboard coins)
+{
+#ifdef _MSC_VER
+    return (int)__popcnt64(coins);
+#else
+    return __builtin_popcountll(coins);
+#endif
+}
+
+template <int Rows, int Columns, int WinLength>
+Bitboard BasicConnectFourBoard<Rows, Columns, WinLength>::Mirror(Bitboard bits)
+{
+    const Bitboard column = (Bitboard(1) << COLUMN_HEIGHT) - 1;
+
+    Bitboard mirrored = 0;
+    for (int i = 0; i < COLUMNS; i++)
+    {
+        mirrored |= ((bits >> (i * COLUMN_HEIGHT)) & column) << ((COLUMNS - 1 - i) * COLUMN_HEIGHT);
+    }
+
+    return mirrored;
+}
+
+template <int Rows, int Columns, int WinLength>
+void BasicConnectFourBoard<Rows, Columns, WinLength>::ResetBoard()
+{
+    coins[Player::HUMAN] = 0;
+    coins[Player::AI] = 0;
+    aiWindowPoints = 0;
+
+    numberOfMoves = 0;
+    currentTurn = Player::HUMAN;
+}
+
+template <int Rows, int Columns, int WinLength>
+bool BasicConnectFourBoard<Rows, Columns, WinLength>::DropCoin(int column, Player whichPlayer)
+{
+    if (column < 0 || column >= COLUMNS) return false;
+
+    // Adding the bottom bit carries up through the filled cells onto the first free one
+    Bitboard move = (GetHeightMask() + BottomMask(column)) & ColumnMask(column);
+
+    // Couldn't drop a coin. The column is full
+    if (move == 0) return false;
+
+    coins[whichPlayer] |= move;
+
+    // Every window through the new coin gets one more AI coin in it
+    if (whichPlayer == Player::AI) aiWindowPoints += WindowsThroughCell<BasicConnectFourBoard>(move);
+
+    numberOfMoves += 1;
+    return true;
+}
+
+template <int Rows, int Columns, int WinLength>
+bool BasicConnectFourBoard<Rows, Columns, WinLength>::UndoCoin(int column)
+{
+    if (column < 0 || column >= COLUMNS) return false;
+
+    Bitboard columnCoins = GetHeightMask() & ColumnMask(column);
+
+    // Nothing to take back
+    if (columnCoins == 0) return false;
+
+    // The first free cell is right above the top coin
+    Bitboard move = ((columnCoins + BottomMask(column)) >> 1) & columnCoins;
+
+    if (coins[Player::AI] & move) aiWindowPoints -= WindowsThroughCell<BasicConnectFourBoard>(move);
+
+    coins[Player::HUMAN] &= ~move;
+    coins[Player::AI] &= ~move;
+
+    numberOfMoves -= 1;
+    return true;
+}
+
+template <int Rows, int Columns, int WinLength>
+Player BasicConnectFourBoard<Rows, Columns, WinLength>::GetPlayerTurn() const
 {
     return currentTurn;
 }
 
-void ConnectFourBoard::SetPlayerTurn(Player player)
+template <int Rows, int Columns, int WinLength>
+void BasicConnectFourBoard<Rows, Columns, WinLength>::SetPlayerTurn(Player player)
 {
     currentTurn = player;
 }
 
-bool ConnectFourBoard::IsFinished()
+template <int Rows, int Columns, int WinLength>
+bool BasicConnectFourBoard<Rows, Columns, WinLength>::IsFinished() const
 {
     return (numberOfMoves == ROWS * COLUMNS);
 }
 
-int ConnectFourBoard::ScorePosition(int row, int column, int delta_y, int delta_x)
+template <int Rows, int Columns, int WinLength>
+int BasicConnectFourBoard<Rows, Columns, WinLength>::GetNumberOfMoves() const
+{
+    return numberOfMoves;
+}
+
+template <int Rows, int Columns, int WinLength>
+int BasicConnectFourBoard<Rows, Columns, WinLength>::ScorePosition(int row, int column, int delta_y, int delta_x) const
 {
     int human_points = 0;
     int computer_points = 0;
 
-    // Save winning positions in vector for later
-    std::vector<ivec2> winningMoveForHuman;
-    std::vector<ivec2> winningMoveForAI;
-
     // Determine score through amount of available chips
-    for (int i = 0; i < 4; i++)
+    for (int i = 0; i < WIN_LENGTH; i++)
     {
-        // '0' = no chip
-        // '1' = Player chip
-        // '2' = AI chip
+        Bitboard cell = CellBit(row, column);
 
-        if (playingField[row][column] == '1')
+        if (coins[Player::HUMAN] & cell)
         {
-            winningMoveForHuman.push_back(ivec2(row, column));
             human_points++; // Add for each human chip
         }
-        else if (playingField[row][column] == '2')
+        else if (coins[Player::AI] & cell)
         {
-            winningMoveForAI.push_back(ivec2(row, column));
             computer_points++; // Add for each computer chip
         }
 
@@ -127,15 +603,13 @@ int ConnectFourBoard::ScorePosition(int row, int column, int delta_y, int delta_
     }
 
     // If the human matched 4 in a row
-    if (human_points == 4)
+    if (human_points == WIN_LENGTH)
     {
-        winningMove = winningMoveForHuman;
         // Human won (-100000)
         return -MAX_SCORE;
     }
-    else if (computer_points == 4)
+    else if (computer_points == WIN_LENGTH)
     {
-        winningMove = winningMoveForAI;
         // Computer won (100000)
         return MAX_SCORE;
     }
@@ -146,164 +620,204 @@ int ConnectFourBoard::ScorePosition(int row, int column, int delta_y, int delta_
     }
 }
 
-int ConnectFourBoard::SimpleScoring()
+template <int Rows, int Columns, int WinLength>
+int BasicConnectFourBoard<Rows, Columns, WinLength>::SimpleScoring() const
 {
-    // Board-size: 7x6 (width x height)
-
-    int vertical_points     = 0;
-    int horizontal_points   = 0;
-    int diagonal_points_1   = 0;
-    int diagonal_points_2   = 0;
-
-    // Vertical points
-    // Check each column for vertical score
-    // 
-    // Possible situations
-    //  0  1  2  3  4  5  6
-    // [x][ ][ ][ ][ ][ ][ ] 0
-    // [x][x][ ][ ][ ][ ][ ] 1
-    // [x][x][x][ ][ ][ ][ ] 2
-    // [x][x][x][ ][ ][ ][ ] 3
-    // [ ][x][x][ ][ ][ ][ ] 4
-    // [ ][ ][x][ ][ ][ ][ ] 5
-    for (int row = 0; row < ROWS - 3; row++) 
+    // Somebody has four in a row, find out who in the same order the windows were always scanned
+    if (FourInARow(coins[Player::HUMAN]) || FourInARow(coins[Player::AI]))
+    {
+        return ScoreWinningBoard();
+    }
+
+    // Without a winner every window is worth the amount of AI coins in it, DropCoin keeps count
+    return aiWindowPoints;
+}
+
+template <int Rows, int Columns, int WinLength>
+int BasicConnectFourBoard<Rows, Columns, WinLength>::ScoreChildren(Player player, int scores[COLUMNS]) const
+{
+    int scored = 0;
+
+    // Somebody already won and the windows decide who, leave that to SimpleScoring
+    if (FourInARow(coins[Player::HUMAN]) || FourInARow(coins[Player::AI]))
     {
-        for (int column = 0; column < COLUMNS; column++) 
+        BasicConnectFourBoard child = *this;
+
+        for (int column = 0; column < COLUMNS; column++)
         {
-            // -------------  Here's a freebie!
-            int score = ScorePosition(row, column, 1, 0);
-            if (score ==  MAX_SCORE) return  MAX_SCORE;
-            if (score == -MAX_SCORE) return -MAX_SCORE;
-            vertical_points += score;
+            if (!child.DropCoin(column, player)) continue;
+
+            scores[column] = child.SimpleScoring();
+            child.UndoCoin(column);
+            scored |= 1 << column;
         }
+
+        return scored;
     }
 
-    // Horizontal points
-    // Check each row's score
-    // 
-    // Possible situations
-    //  0  1  2  3  4  5  6
-    // [x][x][x][x][ ][ ][ ] 0
-    // [ ][x][x][x][x][ ][ ] 1
-    // [ ][ ][x][x][x][x][ ] 2
-    // [ ][ ][ ][x][x][x][x] 3
-    // [ ][ ][ ][ ][ ][ ][ ] 4
-    // [ ][ ][ ][ ][ ][ ][ ] 5
-    for (int row = 0; row < ROWS; row++) 
+    // The first free cell of every column at once, full columns have none
+    Bitboard moves = (GetHeightMask() + BottomRow<BasicConnectFourBoard>()) & BoardMask<BasicConnectFourBoard>();
+
+    // One look at the player's coins tells which of those moves win
+    Bitboard winningMoves = moves & CompletingCells<BasicConnectFourBoard>(coins[player]);
+
+    for (int column = 0; column < COLUMNS; column++)
     {
-        for (int column = 0; column < COLUMNS - 3; column++) 
+        Bitboard move = moves & ColumnMask(column);
+        if (move == 0) continue;
+
+        if (move & winningMoves)
+        {
+            // Only the player that moved can have a line, so it's the first complete window too
+            scores[column] = player == Player::AI ? MAX_SCORE : -MAX_SCORE;
+        }
+        else
         {
-			int score = ScorePosition(row, column, 0, 1);
-			if (score == MAX_SCORE) return  MAX_SCORE;
-			if (score == -MAX_SCORE) return -MAX_SCORE;
-			horizontal_points += score;
+            // Same as DropCoin keeps count
+            scores[column] = aiWindowPoints + (player == Player::AI ? WindowsThroughCell<BasicConnectFourBoard>(move) : 0);
         }
+
+        scored |= 1 << column;
     }
 
-    // Diagonal points 1 (left-bottom)
-    //
-    // Possible situation
-    //  0  1  2  3  4  5  6
-    // [x][ ][ ][x][ ][ ][ ] 0
-    // [ ][x][ ][ ][x][ ][ ] 1
-    // [x][ ][x][ ][ ][x][ ] 2
-    // [ ][x][ ][x][ ][ ][x] 3
-    // [ ][ ][x][ ][ ][ ][ ] 4
-    // [ ][ ][ ][x][ ][ ][ ] 5
-	for (int row = 0; row < 4; row++)
-	{
-		for (int column = 0; column < 3; column++)
-		{
-			int score = ScorePosition(row, column, 1, 1);
-			if (score == MAX_SCORE) return  MAX_SCORE;
-			if (score == -MAX_SCORE) return -MAX_SCORE;
-			diagonal_points_1 += score;
-		}
-	}
-
-    // Diagonal points 2 (right-bottom)
-    //
-    // Possible situation
-    //  0  1  2  3  4  5  6
-    // [ ][ ][ ][x][ ][ ][ ] 0
-    // [ ][ ][x][ ][ ][ ][ ] 1
-    // [ ][x][ ][ ][ ][ ][x] 2
-    // [x][ ][ ][ ][ ][x][ ] 3
-    // [ ][ ][ ][ ][x][ ][ ] 4
-    // [ ][ ][ ][x][ ][ ][ ] 5
-	for (int row = 0; row < 3; row++)
-	{
-		for (int column = 3; column < COLUMNS; column++)
-		{
-			int score = ScorePosition(row, column, 1, -1);
-			if (score == MAX_SCORE) return  MAX_SCORE;
-			if (score == -MAX_SCORE) return -MAX_SCORE;
-			diagonal_points_2 += score;
-		}
-	}
-
-    return vertical_points + horizontal_points + diagonal_points_1 + diagonal_points_2;
+    return scored;
 }
 
-ConnectFourBoard ConnectFourBoard::CreateCopy()
+template <int Rows, int Columns, int WinLength>
+int BasicConnectFourBoard<Rows, Columns, WinLength>::PatternScoring() const
 {
-    ConnectFourBoard newBoard;
-    newBoard.currentTurn = this->currentTurn;
-    newBoard.winningMove = this->winningMove;
-    newBoard.numberOfMoves = this->numberOfMoves;
+    // A winner is scored the same as SimpleScoring does it
+    if (FourInARow(coins[Player::HUMAN]) || FourInARow(coins[Player::AI]))
+    {
+        return ScoreWinningBoard();
+    }
 
-    // Don't need to worry about the textures, they're not used
-    // And same with the constant values
+    return PatternPoints();
+}
 
-    // But we need to copy the values in the board
-    for (int i = 0; i < ROWS; i++)
+template <int Rows, int Columns, int WinLength>
+int BasicConnectFourBoard<Rows, Columns, WinLength>::PatternPoints() const
+{
+    const PatternLineTable<BasicConnectFourBoard>& table = GetPatternLines<BasicConnectFourBoard>();
+
+    int points = 0;
+    for (int i = 0; i < table.lineCount; i++)
     {
-        for (int j = 0; j < COLUMNS; j++)
-        {
-            newBoard.playingField[i][j] = this->playingField[i][j];
-        }
+        const PatternLine& line = table.lines[i];
+        points += table.scores[line.offset + table.LineIndex(coins, line)];
     }
 
-    return newBoard;
+    return points;
 }
 
-void ConnectFourBoard::DrawBoard(std::function<void(vec2, vec2)> drawQuadFunction)
+template <int Rows, int Columns, int WinLength>
+int BasicConnectFourBoard<Rows, Columns, WinLength>::PatternDelta(int column, Player player) const
 {
-    vec2 coinSize = vec2(PIXEL_WIDTH, PIXEL_HEIGHT) / vec2((float)COLUMNS, (float)ROWS);
-    vec2 coinBias = coinSize / 2.0f;
+    Bitboard move = (GetHeightMask() + BottomMask(column)) & ColumnMask(column);
+    if (move == 0) return 0;
 
-    glBindTexture(GL_TEXTURE_2D, background);
-    for (int i = 0; i < ROWS; i++)
+    const PatternLineTable<BasicConnectFourBoard>& table = GetPatternLines<BasicConnectFourBoard>();
+    int cell = CountCoins(move - 1);
+
+    // The coin adds its digit to the four lines through the cell, nothing else changes
+    int digit = player == Player::AI ? 1 : 2;
+    int delta = 0;
+
+    for (int direction = 0; direction < 4; direction++)
     {
-        for (int j = 0; j < COLUMNS; j++)
-        {
-            vec2 pos = coinBias + (coinSize * vec2(j, ROWS - 1 - i));
+        int lineIndex = table.lineThroughCell[cell][direction];
+        if (lineIndex < 0) continue;
 
-            drawQuadFunction(pos, coinSize);
-        }
+        const PatternLine& line = table.lines[lineIndex];
+        const int16_t* scores = &table.scores[line.offset + table.LineIndex(coins, line)];
+
+        delta += scores[digit * table.power3[table.positionOnLine[cell][direction]]] - scores[0];
     }
 
-    for (auto itr = fallingTokens.begin(); itr != fallingTokens.end(); itr++)
+    return delta;
+}
+
+template <int Rows, int Columns, int WinLength>
+int BasicConnectFourBoard<Rows, Columns, WinLength>::GetChildren(Player player, int& winningColumns) const
+{
+    // Same as ScoreChildren
+    Bitboard moves = (GetHeightMask() + BottomRow<BasicConnectFourBoard>()) & BoardMask<BasicConnectFourBoard>();
+    Bitboard winningMoves = moves & CompletingCells<BasicConnectFourBoard>(coins[player]);
+
+    int legal = 0;
+    winningColumns = 0;
+
+    for (int column = 0; column < COLUMNS; column++)
     {
-        vec4 ft = (*itr);
+        if (moves & ColumnMask(column)) legal |= 1 << column;
+        if (winningMoves & ColumnMask(column)) winningColumns |= 1 << column;
+    }
 
-        int x = (int)ft.y;
-        int y = (int)ft.x;
+    return legal;
+}
 
-        float deltaTime = min(1.0f, (float)glfwGetTime() - ft.z + 0.25f);
+template <int Rows, int Columns, int WinLength>
+int BasicConnectFourBoard<Rows, Columns, WinLength>::ScoreWinningBoard() const
+{
+    Bitboard line = GetWinningLine();
+    if (line == 0) return 0;
 
-        const float a = 3.1415f * (4.0f * deltaTime - 1.0f);
-        float interp = 1.0f - abs(sin(a) / a);
-        {
-            if (ft.w < 0.5f)    glBindTexture(GL_TEXTURE_2D, coinTexture[(int)playerColor]);
-            else                glBindTexture(GL_TEXTURE_2D, coinTexture[(int)aiColor]);
+    // Human won (-100000), computer won (100000)
+    return (coins[Player::HUMAN] & line) == line ? -MAX_SCORE : MAX_SCORE;
+}
 
-            vec2 posA = coinBias + (coinSize * vec2(x, ROWS * 2 - y));
-            vec2 posB = coinBias + (coinSize * vec2(x, ROWS - 1 - y));
+template <int Rows, int Columns, int WinLength>
+Bitboard BasicConnectFourBoard<Rows, Columns, WinLength>::GetWinningLine() const
+{
+    // Nobody won, no need to look at the windows
+    if (!FourInARow(coins[Player::HUMAN]) && !FourInARow(coins[Player::AI])) return 0;
 
-            vec2 position = mix(posA, posB, interp);
+    for (int i = 0; i < WINDOW_COUNT; i++)
+    {
+        Bitboard mask = SCORING_WINDOWS<BasicConnectFourBoard>.windows[i].mask;
 
-            drawQuadFunction(position, coinSize);
-        }
+        if ((coins[Player::HUMAN] & mask) == mask || (coins[Player::AI] & mask) == mask) return mask;
     }
-}
\ No newline at end of file
+
+    return 0;
+}
+
+template <int Rows, int Columns, int WinLength>
+BasicConnectFourBoard<Rows, Columns, WinLength> BasicConnectFourBoard<Rows, Columns, WinLength>::CreateCopy() const
+{
+    // Nothing but plain values in here
+    return *this;
+}
+
+template <int Rows, int Columns, int WinLength>
+uint64_t BasicConnectFourBoard<Rows, Columns, WinLength>::GetPositionKey() const
+{
+    // The height mask plus the bottom row marks the first free cell of every column, adding
+    // one player's coins on top of that can't carry into another column
+    return coins[Player::AI] + GetHeightMask() + BottomRow<BasicConnectFourBoard>();
+}
+
+template <int Rows, int Columns, int WinLength>
+Bitboard BasicConnectFourBoard<Rows, Columns, WinLength>::GetCoins(Player player) const
+{
+    return coins[player];
+}
+
+template <int Rows, int Columns, int WinLength>
+Bitboard BasicConnectFourBoard<Rows, Columns, WinLength>::GetHeightMask() const
+{
+    return coins[Player::HUMAN] | coins[Player::AI];
+}
+
+// The variants from ConnectFour.h, add a line here for another size
+template class BasicConnectFourBoard<6, 7, 4>;
+template class BasicConnectFourBoard<7, 8, 4>;
+template class BasicConnectFourBoard<6, 7, 5>;
+
+// The searches copy boards around all the time, keep them cheap to copy
+static_assert(std::is_trivially_copyable<ConnectFourBoard>::value, "ConnectFourBoard has to stay trivially copyable");
+static_assert(sizeof(ConnectFourBoard) <= 24, "ConnectFourBoard has to stay small");
+
+static_assert(SCORING_WINDOWS<ConnectFourBoard>.count == ConnectFourBoard::WINDOW_COUNT, "Every window has to be in the table");
+static_assert(SCORING_WINDOWS<ConnectFourBoard8x7>.count == ConnectFourBoard8x7::WINDOW_COUNT, "Every window has to be in the table");
+static_assert(SCORING_WINDOWS<ConnectFiveBoard>.count == ConnectFiveBoard::WINDOW_COUNT, "Every window has to be in the table");
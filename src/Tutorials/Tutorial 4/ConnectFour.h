@@ -1,71 +1,133 @@
 #ifndef CONNECT_FOUR_H
 #define CONNECT_FOUR_H
 
-#include <GL/gl3w.h>
-#include <functional>
-#include <GLM/glm.hpp>
-#include <vector>
+#include <stdint.h>
 
-enum Player
+enum Player : uint8_t
 {
     HUMAN   = 0,
     AI      = 1,
 };
 
-enum Color
+// How the searches score a board nobody has won yet
+enum class Evaluation : uint8_t
 {
-    GOLD    = 0,
-    RED     = 1,
-    BLUE    = 2,
-    GREEN   = 3,
+    WINDOW_COUNT    = 0,    // SimpleScoring
+    PATTERNS        = 1,    // PatternScoring
 };
 
-class ConnectFourBoard
+// One bit per cell of the board. See BasicConnectFourBoard::CellBit for the layout.
+typedef uint64_t Bitboard;
+
+// The rules of the game and nothing else. Small and plain enough to copy around freely, the searches use
+// it without any graphics attached. ConnectFourView draws it.
+//
+// The size of the board and the length of a winning line are template arguments, so the window table
+// and the shifts are worked out by the compiler for every variant. The member functions live in
+// ConnectFour.cpp, the variants at the bottom of this file are the ones compiled in there.
+template <int Rows, int Columns, int WinLength>
+class BasicConnectFourBoard
 {
 public:
-    ConnectFourBoard();
-
-    void InitializeBoard();
+    BasicConnectFourBoard();
 
     void ResetBoard();
     bool DropCoin(int column, Player whichPlayer);
 
-    Player GetPlayerTurn();
+    // Takes the top coin out of the column again, the board is like it was before the coin was dropped
+    bool UndoCoin(int column);
+
+    Player GetPlayerTurn() const;
     void SetPlayerTurn(Player player);
 
-    bool IsFinished();
+    bool IsFinished() const;
+    int GetNumberOfMoves() const;
+
+    int ScorePosition(int row, int column, int delta_y, int delta_x) const;
+    int SimpleScoring() const;
+
+    // SimpleScoring of the board after the player drops a coin in each column, all in one go and
+    // without touching the board. Returns the columns that could take a coin, one bit per column.
+    int ScoreChildren(Player player, int scores[Columns]) const;
+
+    // Every window looked up by its contents in a table, so the human's coins and threats count too and
+    // a threat is worth more on a row its player can usually get. Wins are scored like SimpleScoring.
+    int PatternScoring() const;
 
-    int ScorePosition(int row, int column, int delta_y, int delta_x);
-    int SimpleScoring();
+    // PatternScoring without looking for a winner, and how much it changes when the player drops a coin
+    // in the column (0 for a full column). The searches keep count with PatternDelta.
+    int PatternPoints() const;
+    int PatternDelta(int column, Player player) const;
 
-    ConnectFourBoard CreateCopy();
+    // The columns that could take a coin and, in winningColumns, the ones where the player's coin would complete
+    // a line, one bit per column. For scoring the children with PatternDelta one at a time.
+    int GetChildren(Player player, int& winningColumns) const;
 
-    void DrawBoard(std::function<void(glm::vec2, glm::vec2)> drawQuadFunction);
+    // The cells of the four in a row that decided the game, 0 while nobody has won.
+    // Looks through all windows, meant for when the game is over and not for the searches.
+    Bitboard GetWinningLine() const;
+
+    BasicConnectFourBoard CreateCopy() const;
+
+    // Different for every arrangement of coins on the board
+    uint64_t GetPositionKey() const;
+
+    Bitboard GetCoins(Player player) const;
+    Bitboard GetHeightMask() const;
 
 public:
     // The winning and losing score
-    const int MAX_SCORE = 100000;
+    const static int MAX_SCORE = 100000;
 
-    const static int PIXEL_WIDTH = 392;
-    const static int PIXEL_HEIGHT = 408;
+    const static int ROWS = Rows;
+    const static int COLUMNS = Columns;
 
-    const static int ROWS = 6;
-    const static int COLUMNS = 7;
-	
-private:
-    char playingField[ROWS][COLUMNS];
+    // Coins in a row that win the game
+    const static int WIN_LENGTH = WinLength;
+
+    // Every column gets an extra (always empty) bit on top so shifts can't wrap into the next column
+    const static int COLUMN_HEIGHT = ROWS + 1;
 
-    std::vector<glm::vec4> fallingTokens;
+    // Number of winning windows SimpleScoring looks at (69 on a 7x6 board with four in a row)
+    const static int WINDOW_COUNT = (ROWS - WIN_LENGTH + 1) * COLUMNS + ROWS * (COLUMNS - WIN_LENGTH + 1) +
+        2 * (ROWS - WIN_LENGTH + 1) * (COLUMNS - WIN_LENGTH + 1);
 
-    Player currentTurn = Player::HUMAN;
-    GLuint coinTexture[4];
-    GLuint background;
+    static_assert(COLUMNS * COLUMN_HEIGHT <= 64, "The board has to fit in a bitboard");
+    static_assert(WIN_LENGTH >= 2 && WIN_LENGTH <= ROWS && WIN_LENGTH <= COLUMNS, "A winning line has to fit on the board");
+    static_assert(ROWS * COLUMNS <= 127, "The number of moves is kept in a byte");
 
-    const Color playerColor = Color::BLUE;
-    const Color aiColor     = Color::RED;
+    // Bit of a cell, row 0 is the top of the board
+    static Bitboard CellBit(int row, int column);
+    static Bitboard BottomMask(int column);
+    static Bitboard ColumnMask(int column);
 
-    std::vector<glm::ivec2> winningMove;
-    int numberOfMoves   = 0;
+    // Non zero if the coins contain a winning line (WIN_LENGTH in a row) in any direction
+    static Bitboard FourInARow(Bitboard coins);
+    static int CountCoins(Bitboard coins);
+
+    // The columns in the opposite order, like the board seen in a mirror
+    static Bitboard Mirror(Bitboard bits);
+
+private:
+    int ScoreWinningBoard() const;
+
+private:
+    // One bitboard per player, together they are the height map
+    Bitboard coins[2];
+
+    // SimpleScoring without a winner, the sum of the AI coins in every window. Only the windows
+    // through a dropped or undone coin change, so DropCoin and UndoCoin add or take away those.
+    int16_t aiWindowPoints;
+
+    int8_t numberOfMoves;
+    Player currentTurn;
 };
 
-#endif
\ No newline at end of file
+// The board the game and the searches play on
+typedef BasicConnectFourBoard<6, 7, 4> ConnectFourBoard;
+
+// Other variants, compiled in too
+typedef BasicConnectFourBoard<7, 8, 4> ConnectFourBoard8x7;
+typedef BasicConnectFourBoard<6, 7, 5> ConnectFiveBoard;
+
+#endif
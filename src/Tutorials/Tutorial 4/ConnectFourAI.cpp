@@ -0,0 +1,1098 @@
+#include "ConnectFourAI.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <limits.h>
+#include <math.h>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Bigger than any score the board can give
+    const int INFINITE_SCORE = 1000000;
+
+    // Center columns take part in the most windows, so they are tried first
+    //  3, 2, 4, 1, 5, 0, 6
+    struct ColumnOrder
+    {
+        int columns[ConnectFourBoard::COLUMNS];
+
+        ColumnOrder()
+        {
+            for (int i = 0; i < ConnectFourBoard::COLUMNS; i++)
+            {
+                int offset = (i + 1) / 2;
+                columns[i] = ConnectFourBoard::COLUMNS / 2 + (i % 2 == 1 ? -offset : offset);
+            }
+        }
+    };
+
+    const ColumnOrder centerFirst;
+
+    // The center first order with the best move from an earlier search in front
+    struct MoveOrder
+    {
+        int columns[ConnectFourBoard::COLUMNS];
+
+        MoveOrder(int firstMove)
+        {
+            int count = 0;
+            if (firstMove != NIL) columns[count++] = firstMove;
+
+            for (int i = 0; i < ConnectFourBoard::COLUMNS; i++)
+            {
+                if (centerFirst.columns[i] != firstMove) columns[count++] = centerFirst.columns[i];
+            }
+        }
+    };
+
+    Player Opponent(Player player)
+    {
+        return player == Player::AI ? Player::HUMAN : Player::AI;
+    }
+
+    // The free cell the column's next coin lands on, as a bit index. Full columns get the spare top bit.
+    int NextCellIndex(const ConnectFourBoard& board, int column)
+    {
+        Bitboard cell = (board.GetHeightMask() + ConnectFourBoard::BottomMask(column)) & ConnectFourBoard::ColumnMask(column);
+        return cell ? ConnectFourBoard::CountCoins(cell - 1) : (column + 1) * ConnectFourBoard::COLUMN_HEIGHT - 1;
+    }
+
+    // The killers of the ply first, then the highest history. The table's move stays in front, ties keep
+    // the center first order.
+    void OrderByHeuristics(MoveOrder& order, const ConnectFourBoard& board, Player player, bool keepFirst, const MoveHeuristics& heuristics)
+    {
+        const int8_t* killers = heuristics.killers[board.GetNumberOfMoves()];
+
+        int keys[ConnectFourBoard::COLUMNS];
+        int first = keepFirst ? 1 : 0;
+
+        for (int i = first; i < ConnectFourBoard::COLUMNS; i++)
+        {
+            int column = order.columns[i];
+
+            if (column == killers[0])       keys[i] = INT_MAX;
+            else if (column == killers[1])  keys[i] = INT_MAX - 1;
+            else                            keys[i] = heuristics.history[player][NextCellIndex(board, column)];
+        }
+
+        // Insertion sort, seven columns at most
+        for (int i = first + 1; i < ConnectFourBoard::COLUMNS; i++)
+        {
+            int column = order.columns[i];
+            int key = keys[i];
+
+            int j = i;
+            for (; j > first && keys[j - 1] < key; j--)
+            {
+                order.columns[j] = order.columns[j - 1];
+                keys[j] = keys[j - 1];
+            }
+
+            order.columns[j] = column;
+            keys[j] = key;
+        }
+    }
+
+    // The column was good enough to stop searching the other ones
+    void RememberCutoff(MoveHeuristics& heuristics, const ConnectFourBoard& board, Player player, int column, int depth)
+    {
+        int8_t* killers = heuristics.killers[board.GetNumberOfMoves()];
+        if (killers[0] != column)
+        {
+            killers[1] = killers[0];
+            killers[0] = (int8_t)column;
+        }
+
+        int32_t& history = heuristics.history[player][NextCellIndex(board, column)];
+        history += depth * depth;
+
+        // Keep room to count, the order of the moves is what matters
+        if (history > (1 << 24))
+        {
+            for (int p = 0; p < 2; p++)
+                for (int cell = 0; cell < 64; cell++) heuristics.history[p][cell] /= 2;
+        }
+    }
+
+    // The board scored for the AI, the way the context asks for
+    int ScoreBoard(const ConnectFourBoard& board, const SearchContext& context)
+    {
+        if (context.evaluation == Evaluation::WINDOW_COUNT) return board.SimpleScoring();
+
+        // Same as PatternScoring, without going over the whole board again
+        if (ConnectFourBoard::FourInARow(board.GetCoins(Player::HUMAN)) || ConnectFourBoard::FourInARow(board.GetCoins(Player::AI)))
+        {
+            return board.PatternScoring();
+        }
+
+        return context.patternPoints;
+    }
+
+    // Below this depth the killers and the history don't reorder the moves
+    const int MOVE_HEURISTICS_MIN_DEPTH = 4;
+
+    // Below this depth starting threads costs more than the search
+    const int PARALLEL_MIN_DEPTH = 4;
+
+    // Looking at the clock every node would cost more than the nodes themselves
+    const long long NODES_BETWEEN_CLOCK_CHECKS = 1024;
+
+    // The deadline passed or somebody cancelled the search
+    bool OutOfTime(SearchContext& context)
+    {
+        if (context.aborted) return true;
+
+        if (context.statistics.nodes % NODES_BETWEEN_CLOCK_CHECKS != 0) return false;
+
+        if (context.useDeadline && std::chrono::steady_clock::now() >= context.deadline)
+        {
+            context.aborted = true;
+        }
+
+        if (context.cancelled && context.cancelled->load(std::memory_order_relaxed))
+        {
+            context.aborted = true;
+        }
+
+        return context.aborted;
+    }
+
+    // Where a position goes in the transposition table. The same coins with a different player to move
+    // is a different search.
+    //
+    // With mirroring a position and its mirror image share the entry of the smaller key, the best move
+    // is stored for that one and flipped back for the other.
+    struct TableKey
+    {
+        uint64_t key;
+        bool mirrored;
+    };
+
+    TableKey GetTableKey(const ConnectFourBoard& board, Player player, bool useMirrorSymmetry)
+    {
+        uint64_t position = board.GetPositionKey();
+        bool mirrored = false;
+
+        if (useMirrorSymmetry)
+        {
+            // The key is made of one part per column, so the mirrored key is the key of the mirror image
+            uint64_t mirror = ConnectFourBoard::Mirror(position);
+            if (mirror < position)
+            {
+                position = mirror;
+                mirrored = true;
+            }
+        }
+
+        return TableKey{ position | (player == Player::AI ? uint64_t(1) << 63 : 0), mirrored };
+    }
+
+    int MirrorMove(int move, bool mirrored)
+    {
+        return mirrored && move != NIL ? ConnectFourBoard::COLUMNS - 1 - move : move;
+    }
+
+    bool ProbeTable(const TranspositionTable* table, const TableKey& key, TranspositionEntry& entry, TranspositionStatistics& statistics)
+    {
+        if (!table || !table->Probe(key.key, entry, statistics)) return false;
+
+        entry.bestMove = (int8_t)MirrorMove(entry.bestMove, key.mirrored);
+        return true;
+    }
+
+    void StoreTable(TranspositionTable* table, const TableKey& key, int depth, int score, Bound bound, int bestMove, TranspositionStatistics& statistics)
+    {
+        if (table) table->Store(key.key, depth, score, bound, MirrorMove(bestMove, key.mirrored), statistics);
+    }
+}
+
+void SearchStatistics::Add(const SearchStatistics& other)
+{
+    nodes               += other.nodes;
+    cutoffs             += other.cutoffs;
+    rootSearches        += other.rootSearches;
+    firstMoveCutoffs    += other.firstMoveCutoffs;
+    aiScoreTotal        += other.aiScoreTotal;
+    aiScoreCount        += other.aiScoreCount;
+    playerScoreTotal    += other.playerScoreTotal;
+    playerScoreCount    += other.playerScoreCount;
+    table.Add(other.table);
+}
+
+float SearchStatistics::GetFirstMoveCutoffRate() const
+{
+    return cutoffs > 0 ? (float)firstMoveCutoffs / cutoffs : 0.0f;
+}
+
+std::string SearchStatistics::ToJson() const
+{
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "{\"nodes\":%lld,\"depth\":%d,\"cutoffs\":%lld,\"firstMoveCutoffs\":%lld,\"rootSearches\":%lld,\"tableProbes\":%lld,\"tableHits\":%lld,\"iterations\":[",
+        nodes, depth, cutoffs, firstMoveCutoffs, rootSearches, table.probes, table.hits);
+
+    std::string json = buffer;
+
+    for (size_t i = 0; i < iterations.size(); i++)
+    {
+        const IterationStatistics& iteration = iterations[i];
+        snprintf(buffer, sizeof(buffer), "%s{\"depth\":%d,\"nodes\":%lld,\"cutoffs\":%lld,\"rootSearches\":%lld,\"tableProbes\":%lld,\"tableHits\":%lld,\"ms\":%.3f,\"branchingFactor\":%.3f,\"score\":%d}",
+            i > 0 ? "," : "", iteration.depth, iteration.nodes, iteration.cutoffs, iteration.rootSearches, iteration.tableProbes, iteration.tableHits,
+            iteration.milliseconds, iteration.branchingFactor, iteration.score);
+        json += buffer;
+    }
+
+    return json + "]}";
+}
+
+MoveHeuristics::MoveHeuristics()
+{
+    Clear();
+}
+
+void MoveHeuristics::Clear()
+{
+    for (int ply = 0; ply <= ConnectFourBoard::ROWS * ConnectFourBoard::COLUMNS; ply++)
+    {
+        killers[ply][0] = NIL;
+        killers[ply][1] = NIL;
+    }
+
+    for (int player = 0; player < 2; player++)
+        for (int cell = 0; cell < 64; cell++) history[player][cell] = 0;
+}
+
+ColumnScore MaximizePlay(ConnectFourBoard& board, int depth, SearchStatistics& statistics, const std::atomic<bool>* cancelled)
+{
+    // Call score of our board
+    int score = board.SimpleScoring();
+    statistics.nodes++;
+    statistics.aiScoreTotal += score;
+    statistics.aiScoreCount++;
+
+    // Break
+    if (board.IsFinished() || depth == 0) return ColumnScore(NIL, score);
+
+    // Nobody wants the result anymore, the leaves are scored in one go so only the nodes above them look
+    if (cancelled && cancelled->load(std::memory_order_relaxed)) return ColumnScore(NIL, score);
+
+    // Column, Score
+    ColumnScore max = ColumnScore(NIL, -99999);
+
+    // The last move before the leaves, score all of them at once
+    int leafScores[ConnectFourBoard::COLUMNS];
+    int leaves = depth == 1 ? board.ScoreChildren(Player::AI, leafScores) : 0;
+
+    // For all possible moves
+    for (int column = 0; column < board.COLUMNS; column++)
+    {
+        if (leaves & (1 << column))
+        {
+            // What MinimizePlay would count for the leaf
+            statistics.nodes++;
+            statistics.playerScoreTotal += leafScores[column];
+            statistics.playerScoreCount++;
+
+            if (max[0] == NIL || leafScores[column] > max[1])
+            {
+                max[0] = column;
+                max[1] = leafScores[column];
+            }
+        }
+        else if (depth > 1 && board.DropCoin(column, Player::AI)) // Play the move on the board
+        {
+            ColumnScore nextMove = MinimizePlay(board, depth - 1, statistics, cancelled); // Recursive calling
+            board.UndoCoin(column); // And take it back
+
+            // Evaluate new move
+            if (max[0] == NIL || nextMove[1] > max[1])
+            {
+                max[0] = column;
+                max[1] = nextMove[1];
+            }
+        }
+    }
+
+    return max;
+}
+
+ColumnScore MinimizePlay(ConnectFourBoard& board, int depth, SearchStatistics& statistics, const std::atomic<bool>* cancelled)
+{
+    int score = board.SimpleScoring();
+    statistics.nodes++;
+    statistics.playerScoreTotal += score;
+    statistics.playerScoreCount++;
+
+    if (board.IsFinished() || depth == 0) return ColumnScore(NIL, score);
+
+    if (cancelled && cancelled->load(std::memory_order_relaxed)) return ColumnScore(NIL, score);
+
+    ColumnScore min = ColumnScore(NIL, 99999);
+
+    int leafScores[ConnectFourBoard::COLUMNS];
+    int leaves = depth == 1 ? board.ScoreChildren(Player::HUMAN, leafScores) : 0;
+
+    for (int column = 0; column < board.COLUMNS; column++)
+    {
+        if (leaves & (1 << column))
+        {
+            statistics.nodes++;
+            statistics.aiScoreTotal += leafScores[column];
+            statistics.aiScoreCount++;
+
+            if (min[0] == NIL || leafScores[column] < min[1])
+            {
+                min[0] = column;
+                min[1] = leafScores[column];
+            }
+        }
+        else if (depth > 1 && board.DropCoin(column, Player::HUMAN))
+        {
+            ColumnScore nextMove = MaximizePlay(board, depth - 1, statistics, cancelled);
+            board.UndoCoin(column);
+
+            if (min[0] == NIL || nextMove[1] < min[1])
+            {
+                min[0] = column;
+                min[1] = nextMove[1];
+            }
+        }
+    }
+    return min;
+}
+
+int Negamax(ConnectFourBoard& board, int depth, int alpha, int beta, Player player, SearchContext& context)
+{
+    context.statistics.nodes++;
+    if (OutOfTime(context)) return 0;
+
+    // The board is always scored for the AI, flip it when the human is to move
+    if (board.IsFinished() || depth == 0)
+    {
+        int score = ScoreBoard(board, context);
+        return player == Player::AI ? score : -score;
+    }
+
+    TranspositionTable* table = context.transpositionTable;
+    TableKey key = GetTableKey(board, player, context.useMirrorSymmetry);
+    int tableMove = NIL;
+
+    TranspositionEntry entry;
+    if (ProbeTable(table, key, entry, context.statistics.table))
+    {
+        tableMove = entry.bestMove;
+
+        // The board score doesn't settle as the search gets deeper, so a deeper result would give a
+        // different answer than searching this depth. Only same depth results stand in for a search.
+        if (entry.depth == depth)
+        {
+            if (entry.bound == Bound::EXACT) return entry.score;
+            if (entry.bound == Bound::LOWER && entry.score > alpha) alpha = entry.score;
+            if (entry.bound == Bound::UPPER && entry.score < beta) beta = entry.score;
+            if (alpha >= beta) return entry.score;
+        }
+    }
+
+    // What the result is compared against to know if it's a bound
+    int windowAlpha = alpha;
+
+    int best = -INFINITE_SCORE;
+    int bestMove = NIL;
+
+    // Right above the leaves the children are scored here instead of one call each. SimpleScoring does all
+    // of them in one go, the patterns only the moves that are tried.
+    bool usePatterns = context.evaluation == Evaluation::PATTERNS;
+    bool scoreLeaves = depth == 1;
+
+    int leafScores[ConnectFourBoard::COLUMNS];
+    int leaves = 0;
+    int winningLeaves = 0;
+
+    if (scoreLeaves && !usePatterns)
+    {
+        leaves = board.ScoreChildren(player, leafScores);
+    }
+    else if (scoreLeaves)
+    {
+        // Somebody already won, the leaves go through ScoreBoard like any other board
+        if (ConnectFourBoard::FourInARow(board.GetCoins(Player::HUMAN)) || ConnectFourBoard::FourInARow(board.GetCoins(Player::AI)))
+            scoreLeaves = false;
+        else
+            leaves = board.GetChildren(player, winningLeaves);
+    }
+
+    // Close to the leaves sorting the moves costs more than the cutoffs it adds
+    bool useMoveHeuristics = context.useMoveHeuristics && depth >= MOVE_HEURISTICS_MIN_DEPTH;
+
+    MoveOrder order(tableMove);
+    if (useMoveHeuristics) OrderByHeuristics(order, board, player, tableMove != NIL, context.heuristics);
+
+    // Legal moves searched so far
+    int tried = 0;
+
+    for (int i = 0; i < board.COLUMNS; i++)
+    {
+        int column = order.columns[i];
+        int score;
+
+        if (scoreLeaves)
+        {
+            if (!(leaves & (1 << column))) continue;
+            tried++;
+
+            // Counted like the leaf had been visited
+            context.statistics.nodes++;
+            if (OutOfTime(context)) return 0;
+
+            int leafScore;
+            if (!usePatterns)                           leafScore = leafScores[column];
+            else if (winningLeaves & (1 << column))     leafScore = player == Player::AI ? ConnectFourBoard::MAX_SCORE : -ConnectFourBoard::MAX_SCORE;
+            else                                        leafScore = context.patternPoints + board.PatternDelta(column, player);
+
+            score = player == Player::AI ? leafScore : -leafScore;
+        }
+        else
+        {
+            int patternDelta = usePatterns ? board.PatternDelta(column, player) : 0;
+
+            if (!board.DropCoin(column, player)) continue;
+            tried++;
+
+            context.patternPoints += patternDelta;
+            score = -Negamax(board, depth - 1, -beta, -alpha, Opponent(player), context);
+            board.UndoCoin(column);
+            context.patternPoints -= patternDelta;
+
+            // Half searched, nothing here can be trusted or remembered
+            if (context.aborted) return 0;
+        }
+
+        if (score > best)
+        {
+            best = score;
+            bestMove = column;
+        }
+        if (best > alpha) alpha = best;
+
+        // The opponent already has a better option somewhere else
+        if (alpha >= beta)
+        {
+            context.statistics.cutoffs++;
+            if (tried == 1) context.statistics.firstMoveCutoffs++;
+
+            if (useMoveHeuristics) RememberCutoff(context.heuristics, board, player, column, depth);
+            break;
+        }
+    }
+
+    if (table)
+    {
+        Bound bound = Bound::EXACT;
+        if (best <= windowAlpha) bound = Bound::UPPER;
+        else if (best >= beta) bound = Bound::LOWER;
+
+        StoreTable(table, key, depth, best, bound, bestMove, context.statistics.table);
+    }
+
+    return best;
+}
+
+namespace
+{
+    // The first two plies split into one task per root move and reply, the threads share the tasks.
+    //
+    // A root move is worth the lowest score of its replies. A reply only has to be searched between the best
+    // root move so far (anything below can't be picked) and the lowest reply of its root move so far (anything
+    // above doesn't change the root move). A reply that falls below the best root move rules out its root move,
+    // its replies that haven't started are skipped. Every root move that can still be picked ends up with its
+    // exact score, so the result doesn't depend on which thread finished first.
+    //
+    // Tasks searched with loose bounds do work the serial search doesn't, so tasks wait for the ones that give
+    // them their bounds (young brothers wait):
+    //
+    //  first root move     first reply alone, then the other replies side by side
+    //  other root moves    once the first root move is done, the first reply of each, then the others of
+    //                      the root moves that weren't ruled out by it
+    //
+    // The first reply is the table's move and most often the one that rules the root move out on its own.
+    //
+    // Like SearchRoot the root moves are searched inside [rootAlpha, rootBeta], see SearchRoot for what comes back.
+    ColumnScore ParallelSearchRoot(ConnectFourBoard& board, int depth, Player player, int firstMove, int rootAlpha, int rootBeta, SearchContext& context)
+    {
+        struct RootMove
+        {
+            int column;
+            ConnectFourBoard board;
+            int tasksLeft;
+            int lowestScore;
+            bool ruledOut;
+            int upperBound;     // The lowest reply that ruled the move out
+            int bestReply;      // The reply of the lowest score or the one that ruled the move out
+            bool firstReplyDone;
+        };
+
+        struct Task
+        {
+            int rootMove;
+            int reply;
+            bool first;         // The first reply of the root move, the others wait for it
+            bool taken;
+        };
+
+        TranspositionTable* table = context.transpositionTable;
+        Player opponent = Opponent(player);
+
+        std::vector<RootMove> rootMoves;
+        std::vector<Task> tasks;
+
+        MoveOrder order(firstMove);
+        for (int i = 0; i < board.COLUMNS; i++)
+        {
+            RootMove rootMove = { order.columns[i], board.CreateCopy(), 0, INFINITE_SCORE, false, INFINITE_SCORE, NIL, false };
+
+            if (!rootMove.board.DropCoin(rootMove.column, player)) continue;
+
+            int index = (int)rootMoves.size();
+
+            if (depth == 1 || rootMove.board.IsFinished())
+            {
+                // Nothing to split, the whole root move is one task
+                tasks.push_back(Task{ index, NIL, true, false });
+                rootMove.tasksLeft = 1;
+            }
+            else
+            {
+                TranspositionEntry entry;
+                int replyMove = NIL;
+                if (ProbeTable(table, GetTableKey(rootMove.board, opponent, context.useMirrorSymmetry), entry, context.statistics.table))
+                    replyMove = entry.bestMove;
+
+                MoveOrder replies(replyMove);
+                for (int j = 0; j < board.COLUMNS; j++)
+                {
+                    if (!rootMove.board.DropCoin(replies.columns[j], opponent)) continue;
+                    rootMove.board.UndoCoin(replies.columns[j]);
+
+                    tasks.push_back(Task{ index, replies.columns[j], rootMove.tasksLeft == 0, false });
+                    rootMove.tasksLeft++;
+                }
+            }
+
+            rootMoves.push_back(rootMove);
+        }
+
+        std::mutex mutex;
+        std::condition_variable taskDone;
+        size_t firstOpenTask = 0;
+        int running = 0;
+        bool stopping = false;
+        ColumnScore best = ColumnScore(NIL, -INFINITE_SCORE);
+
+        // Whether the task has the bounds it waits for, see above
+        auto isReady = [&](const Task& task)
+        {
+            const RootMove& rootMove = rootMoves[task.rootMove];
+            const RootMove& firstRootMove = rootMoves[0];
+
+            if (task.rootMove > 0 && firstRootMove.tasksLeft > 0 && !firstRootMove.ruledOut) return false;
+            return task.first || rootMove.firstReplyDone;
+        };
+
+        std::vector<SearchContext> workers(context.threadCount);
+
+        auto work = [&](SearchContext& worker)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            while (true)
+            {
+                // The first task that is ready, skipping the ones of root moves that are ruled out
+                size_t next = tasks.size();
+                bool waiting = false;
+
+                while (firstOpenTask < tasks.size() && tasks[firstOpenTask].taken) firstOpenTask++;
+
+                for (size_t i = firstOpenTask; i < tasks.size() && !stopping; i++)
+                {
+                    Task& candidate = tasks[i];
+                    if (candidate.taken) continue;
+
+                    if (rootMoves[candidate.rootMove].ruledOut)
+                    {
+                        candidate.taken = true;
+                        continue;
+                    }
+
+                    if (!isReady(candidate))
+                    {
+                        waiting = true;
+                        continue;
+                    }
+
+                    next = i;
+                    break;
+                }
+
+                if (stopping || next == tasks.size())
+                {
+                    // Nothing left, or nothing until a running task gives the waiting ones their bounds
+                    if (stopping || !waiting || running == 0)
+                    {
+                        taskDone.notify_all();
+                        return;
+                    }
+
+                    taskDone.wait(lock);
+                    continue;
+                }
+
+                Task& task = tasks[next];
+                task.taken = true;
+                running++;
+
+                RootMove& rootMove = rootMoves[task.rootMove];
+
+                // Minus one so a lower column can still tie the best score
+                int alpha = best[0] != NIL ? std::max(best[1] - 1, rootAlpha) : rootAlpha;
+                int beta = std::min(rootMove.lowestScore, rootBeta);
+
+                // Not searched, the move is already worse than the best one and no better than its lowest reply
+                int score = beta;
+                bool searched = alpha < beta;
+
+                if (searched)
+                {
+                    lock.unlock();
+
+                    // Every task searches its own board, in place
+                    ConnectFourBoard taskBoard = rootMove.board.CreateCopy();
+
+                    if (task.reply != NIL) taskBoard.DropCoin(task.reply, opponent);
+                    if (worker.evaluation == Evaluation::PATTERNS) worker.patternPoints = taskBoard.PatternPoints();
+
+                    if (task.reply == NIL)
+                    {
+                        score = -Negamax(taskBoard, depth - 1, -beta, -alpha, opponent, worker);
+                    }
+                    else
+                    {
+                        score = Negamax(taskBoard, depth - 2, alpha, beta, player, worker);
+                    }
+
+                    lock.lock();
+                }
+
+                running--;
+                taskDone.notify_all();
+
+                if (worker.aborted)
+                {
+                    stopping = true;
+                    return;
+                }
+
+                if (task.first) rootMove.firstReplyDone = true;
+
+                if (score <= alpha)
+                {
+                    rootMove.ruledOut = true;
+                    // Not searched, the lowest reply so far is the one that rules it out
+                    if (score < rootMove.upperBound)
+                    {
+                        rootMove.upperBound = score;
+                        if (searched) rootMove.bestReply = task.reply;
+                    }
+                }
+                else if (searched && score < rootMove.lowestScore)
+                {
+                    rootMove.lowestScore = score;
+                    rootMove.bestReply = task.reply;
+                }
+
+                if (--rootMove.tasksLeft == 0 && !rootMove.ruledOut)
+                {
+                    if (best[0] == NIL || rootMove.lowestScore > best[1] ||
+                        (rootMove.lowestScore == best[1] && rootMove.column < best[0]))
+                    {
+                        best[0] = rootMove.column;
+                        best[1] = rootMove.lowestScore;
+                    }
+
+                    // Failed high, the root is worth at least rootBeta and the other moves don't matter
+                    if (best[1] >= rootBeta) stopping = true;
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < context.threadCount; i++)
+        {
+            workers[i].transpositionTable = context.transpositionTable;
+            workers[i].useDeadline = context.useDeadline;
+            workers[i].deadline = context.deadline;
+            workers[i].cancelled = context.cancelled;
+            workers[i].useMoveHeuristics = context.useMoveHeuristics;
+            workers[i].useMirrorSymmetry = context.useMirrorSymmetry;
+            workers[i].evaluation = context.evaluation;
+
+            // What the earlier depths learned, instead of starting over in every thread
+            workers[i].heuristics = context.heuristics;
+
+            // The calling thread is the first worker
+            if (i > 0) threads.push_back(std::thread(work, std::ref(workers[i])));
+        }
+
+        work(workers[0]);
+
+        for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+        for (int i = 0; i < context.threadCount; i++)
+        {
+            context.statistics.Add(workers[i].statistics);
+            if (workers[i].aborted) context.aborted = true;
+        }
+
+        // The next depth starts from what the calling thread learned
+        context.heuristics = workers[0].heuristics;
+
+        if (context.aborted) return ColumnScore(NIL, 0);
+
+        // The split skips the table at the replies' positions, the next depth wants their best replies first
+        for (const RootMove& rootMove : rootMoves)
+        {
+            if (rootMove.bestReply == NIL) continue;
+
+            if (rootMove.ruledOut)
+            {
+                StoreTable(table, GetTableKey(rootMove.board, opponent, context.useMirrorSymmetry), depth - 1, -rootMove.upperBound,
+                    Bound::LOWER, rootMove.bestReply, context.statistics.table);
+            }
+            else if (rootMove.tasksLeft == 0)
+            {
+                Bound replyBound = rootMove.lowestScore >= rootBeta ? Bound::UPPER : Bound::EXACT;
+                StoreTable(table, GetTableKey(rootMove.board, opponent, context.useMirrorSymmetry), depth - 1, -rootMove.lowestScore,
+                    replyBound, rootMove.bestReply, context.statistics.table);
+            }
+        }
+
+        Bound bound = best[1] >= rootBeta ? Bound::LOWER : Bound::EXACT;
+
+        // Failed low, every move was ruled out. The root is worth at most the best of their bounds.
+        if (best[0] == NIL)
+        {
+            bound = Bound::UPPER;
+            best[1] = -INFINITE_SCORE;
+
+            for (const RootMove& rootMove : rootMoves)
+            {
+                if (rootMove.upperBound > best[1]) best[1] = rootMove.upperBound;
+            }
+        }
+
+        StoreTable(table, GetTableKey(board, player, context.useMirrorSymmetry), depth, best[1], bound, best[0], context.statistics.table);
+        return best;
+    }
+
+    // Searches the root moves inside [rootAlpha, rootBeta], the score is for the player to move. Inside the window
+    // the column and score are the ones a full window finds. At rootBeta or above the search failed high, it stopped
+    // at the first move that got there and the score is how much the root is worth at least. At rootAlpha or below
+    // it failed low, the score is how much it is worth at most and there's no column.
+    ColumnScore SearchRoot(ConnectFourBoard& board, int depth, Player player, int firstMove, int rootAlpha, int rootBeta, SearchContext& context)
+    {
+        context.statistics.nodes++;
+        context.statistics.rootSearches++;
+
+        if (context.evaluation == Evaluation::PATTERNS) context.patternPoints = board.PatternPoints();
+
+        if (context.threadCount > 1 && depth >= PARALLEL_MIN_DEPTH)
+        {
+            return ParallelSearchRoot(board, depth, player, firstMove, rootAlpha, rootBeta, context);
+        }
+
+        TranspositionTable* table = context.transpositionTable;
+        TableKey key = GetTableKey(board, player, context.useMirrorSymmetry);
+
+        TranspositionEntry entry;
+        if (firstMove == NIL && ProbeTable(table, key, entry, context.statistics.table)) firstMove = entry.bestMove;
+
+        // Column, Score for the player to move
+        ColumnScore best = ColumnScore(NIL, -INFINITE_SCORE);
+
+        MoveOrder order(firstMove);
+        for (int i = 0; i < board.COLUMNS; i++)
+        {
+            int column = order.columns[i];
+            int patternDelta = context.evaluation == Evaluation::PATTERNS ? board.PatternDelta(column, player) : 0;
+
+            if (!board.DropCoin(column, player)) continue;
+            context.patternPoints += patternDelta;
+
+            // Minimax keeps the lowest column out of equal scores, so a lower column
+            // only has to match the best score while a higher one has to beat it
+            int alpha = rootAlpha;
+            if (best[0] != NIL) alpha = std::max(column < best[0] ? best[1] - 1 : best[1], rootAlpha);
+
+            int score = -Negamax(board, depth - 1, -rootBeta, -alpha, Opponent(player), context);
+            board.UndoCoin(column);
+            context.patternPoints -= patternDelta;
+
+            if (context.aborted) return ColumnScore(NIL, 0);
+
+            if (best[0] == NIL || score > best[1] || (score == best[1] && column < best[0]))
+            {
+                best[0] = column;
+                best[1] = score;
+            }
+
+            if (best[1] >= rootBeta) break;
+        }
+
+        Bound bound = Bound::EXACT;
+        if (best[1] <= rootAlpha)
+        {
+            // The column with the highest bound isn't any better than the others
+            bound = Bound::UPPER;
+            best[0] = NIL;
+        }
+        else if (best[1] >= rootBeta)
+        {
+            bound = Bound::LOWER;
+        }
+
+        StoreTable(table, key, depth, best[1], bound, best[0], context.statistics.table);
+        return best;
+    }
+
+    // First guess of the score for the windows around it, for the player to move. The board score swings
+    // between odd and even depths, the depth two before this one guesses best when the iterations have it.
+    // Otherwise the table has the score of the search before, or the board's own score will do.
+    int GuessScore(ConnectFourBoard& board, int depth, Player player, SearchContext& context)
+    {
+        const std::vector<IterationStatistics>& iterations = context.statistics.iterations;
+        for (size_t i = iterations.size() >= 2 ? iterations.size() - 2 : 0; i < iterations.size(); i++)
+        {
+            if (iterations[i].depth == depth - 2) return player == Player::AI ? iterations[i].score : -iterations[i].score;
+        }
+
+        TranspositionEntry entry;
+        if (ProbeTable(context.transpositionTable, GetTableKey(board, player, context.useMirrorSymmetry), entry, context.statistics.table))
+            return entry.score;
+
+        int score = ScoreBoard(board, context);
+        return player == Player::AI ? score : -score;
+    }
+
+    // One depth of the search, in as many root searches as the window takes. See SearchWindow.
+    //
+    //  FULL        [-inf, inf]
+    //  ASPIRATION  [guess - w, guess + w], the side the score fell out of moves past it by w, w doubles
+    //  MTDF        [g - 1, g] over and over, g the score of the search before, until the bounds meet
+    ColumnScore SearchWindowed(ConnectFourBoard& board, int depth, Player player, int firstMove, SearchContext& context)
+    {
+        if (board.IsFinished() || depth == 0)
+        {
+            context.statistics.nodes++;
+            return ColumnScore(NIL, ScoreBoard(board, context));
+        }
+
+        SearchWindow window = context.window;
+
+        // Every null window would search the whole tree again
+        if (window == SearchWindow::MTDF && !context.transpositionTable) window = SearchWindow::FULL;
+
+        ColumnScore best;
+
+        if (window == SearchWindow::FULL)
+        {
+            best = SearchRoot(board, depth, player, firstMove, -INFINITE_SCORE, INFINITE_SCORE, context);
+        }
+        else if (window == SearchWindow::ASPIRATION)
+        {
+            int guess = GuessScore(board, depth, player, context);
+            int width = std::max(context.aspirationWindow, 1);
+            int alpha = std::max(guess - width, -INFINITE_SCORE);
+            int beta = std::min(guess + width, INFINITE_SCORE);
+
+            while (true)
+            {
+                best = SearchRoot(board, depth, player, firstMove, alpha, beta, context);
+                if (context.aborted) break;
+
+                if (best[1] <= alpha)       alpha = std::max(best[1] - width, -INFINITE_SCORE);
+                else if (best[1] >= beta)   beta = std::min(best[1] + width, INFINITE_SCORE);
+                else break;
+
+                width *= 2;
+            }
+        }
+        else
+        {
+            int score = GuessScore(board, depth, player, context);
+            int lower = -INFINITE_SCORE;
+            int upper = INFINITE_SCORE;
+
+            while (lower < upper)
+            {
+                int beta = std::max(score, lower + 1);
+
+                best = SearchRoot(board, depth, player, firstMove, beta - 1, beta, context);
+                if (context.aborted) break;
+
+                score = best[1];
+                if (score < beta) upper = score;
+                else lower = score;
+            }
+
+            // The score is known, but the null window stopped at the first move that reached it.
+            // Minimax takes the lowest column with that score.
+            if (!context.aborted) best = SearchRoot(board, depth, player, firstMove, score - 1, score + 1, context);
+        }
+
+        if (context.aborted) return ColumnScore(NIL, 0);
+
+        // Back to the AI's point of view like MaximizePlay and MinimizePlay
+        if (player == Player::HUMAN) best[1] = -best[1];
+
+        return best;
+    }
+}
+
+namespace
+{
+    // SearchRoot that keeps track of what the depth cost, see SearchStatistics::iterations
+    ColumnScore SearchIteration(ConnectFourBoard& board, int depth, Player player, int firstMove, SearchContext& context)
+    {
+        SearchStatistics& statistics = context.statistics;
+
+        IterationStatistics before;
+        before.nodes = statistics.nodes;
+        before.cutoffs = statistics.cutoffs;
+        before.rootSearches = statistics.rootSearches;
+        before.tableProbes = statistics.table.probes;
+        before.tableHits = statistics.table.hits;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        ColumnScore result = SearchWindowed(board, depth, player, firstMove, context);
+        if (context.aborted) return result;
+
+        IterationStatistics iteration;
+        iteration.depth = depth;
+        iteration.nodes = statistics.nodes - before.nodes;
+        iteration.cutoffs = statistics.cutoffs - before.cutoffs;
+        iteration.rootSearches = statistics.rootSearches - before.rootSearches;
+        iteration.score = result[1];
+        iteration.tableProbes = statistics.table.probes - before.tableProbes;
+        iteration.tableHits = statistics.table.hits - before.tableHits;
+        iteration.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (!statistics.iterations.empty() && statistics.iterations.back().nodes > 0)
+            iteration.branchingFactor = (float)iteration.nodes / statistics.iterations.back().nodes;
+        else if (depth > 0)
+            iteration.branchingFactor = powf((float)iteration.nodes, 1.0f / depth);
+
+        statistics.iterations.push_back(iteration);
+        return result;
+    }
+}
+
+ColumnScore AlphaBetaPlay(ConnectFourBoard& board, int depth, Player player, SearchContext& context)
+{
+    return SearchIteration(board, depth, player, NIL, context);
+}
+
+ColumnScore IterativeDeepeningPlay(ConnectFourBoard& board, Player player, int maxDepth, float timeBudget, SearchContext& context)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration budget =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(timeBudget));
+
+    context.useDeadline = true;
+    context.deadline = start + budget;
+    context.aborted = false;
+    context.statistics.depth = 0;
+    context.statistics.iterations.clear();
+
+    // Searching deeper than the amount of empty cells gives the same answer again
+    int emptyCells = board.ROWS * board.COLUMNS - board.GetNumberOfMoves();
+    if (maxDepth > emptyCells) maxDepth = emptyCells;
+
+    ColumnScore best = ColumnScore(NIL, 0);
+
+    for (int depth = 1; depth <= maxDepth; depth++)
+    {
+        ColumnScore result = SearchIteration(board, depth, player, best[0], context);
+
+        // The deadline hit in the middle of this depth, the one before it stands
+        if (context.aborted) break;
+
+        best = result;
+        context.statistics.depth = depth;
+
+        // Every depth takes a few times longer than the one before it, when half the budget
+        // is gone the next one won't finish anyway
+        if (std::chrono::steady_clock::now() - start > budget / 2) break;
+    }
+
+    // There wasn't even time for one depth, any legal move beats no move
+    if (best[0] == NIL && !board.IsFinished())
+    {
+        context.useDeadline = false;
+        context.aborted = false;
+        best = SearchIteration(board, 1, player, NIL, context);
+    }
+
+    context.useDeadline = false;
+    return best;
+}
+
+int GetTableMove(ConnectFourBoard& board, Player player, const TranspositionTable& table)
+{
+    TranspositionStatistics statistics;
+    TranspositionEntry entry;
+
+    // Whether the search mirrored the position or not
+    if (ProbeTable(&table, GetTableKey(board, player, false), entry, statistics)) return entry.bestMove;
+    if (ProbeTable(&table, GetTableKey(board, player, true), entry, statistics)) return entry.bestMove;
+
+    return NIL;
+}
+
+ColumnScore SearchPlay(SearchAlgorithm algorithm, ConnectFourBoard& board, int depth, SearchContext& context)
+{
+    switch (algorithm)
+    {
+    case SearchAlgorithm::MINIMAX:      return MaximizePlay(board, depth, context.statistics, context.cancelled);
+    case SearchAlgorithm::ALPHA_BETA:   return AlphaBetaPlay(board, depth, Player::AI, context);
+    case SearchAlgorithm::MONTE_CARLO:  break;
+    }
+
+    return ColumnScore(NIL, 0);
+}
+
+const char* GetSearchAlgorithmName(SearchAlgorithm algorithm)
+{
+    switch (algorithm)
+    {
+    case SearchAlgorithm::MINIMAX:      return "Minimax";
+    case SearchAlgorithm::ALPHA_BETA:   return "Alpha-beta";
+    case SearchAlgorithm::MONTE_CARLO:  return "Monte Carlo";
+    }
+
+    return "Unknown";
+}
+
+const char* GetSearchWindowName(SearchWindow window)
+{
+    switch (window)
+    {
+    case SearchWindow::FULL:        return "Full window";
+    case SearchWindow::ASPIRATION:  return "Aspiration";
+    case SearchWindow::MTDF:        return "MTD(f)";
+    }
+
+    return "Unknown";
+}
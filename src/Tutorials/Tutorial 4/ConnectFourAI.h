@@ -0,0 +1,179 @@
+#ifndef CONNECT_FOUR_AI_H
+#define CONNECT_FOUR_AI_H
+
+#include "ConnectFour.h"
+#include "TranspositionTable.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <GLM/glm.hpp>
+
+// Column, Score
+typedef glm::ivec2 ColumnScore;
+const int NIL = -1; // Because NULL is 0 and we use 0
+
+enum class SearchAlgorithm
+{
+    MINIMAX     = 0,    // MaximizePlay / MinimizePlay, visits every node
+    ALPHA_BETA  = 1,    // Negamax with alpha-beta pruning
+    MONTE_CARLO = 2,    // Monte Carlo tree search, see ConnectFourMCTS.h. Has a budget instead of a depth
+};
+
+// The window the alpha-beta searches search the root in. All of them find the same column and score,
+// they differ in how many nodes it takes.
+enum class SearchWindow
+{
+    FULL        = 0,    // One search from -infinite to infinite
+    ASPIRATION  = 1,    // A narrow window around a guess of the score, widened until the score is inside
+    MTDF        = 2,    // Null windows only, closing in on the score from both sides. Needs the transposition table.
+};
+
+// What one depth of an alpha-beta search cost, the counters of that depth only
+struct IterationStatistics
+{
+    int depth               = 0;
+    long long nodes         = 0;
+    long long cutoffs       = 0;
+    long long rootSearches  = 0;
+    long long tableProbes   = 0;
+    long long tableHits     = 0;
+    float milliseconds      = 0;
+
+    // Effective branching factor, the nodes of this depth per node of the depth before it. The first
+    // depth has nothing to compare with, it takes the depth-th root of its nodes.
+    float branchingFactor   = 0;
+
+    // What the depth found, for the AI
+    int score               = 0;
+};
+
+struct SearchStatistics
+{
+    // Amount of boards that were scored
+    long long nodes = 0;
+
+    // Deepest search that finished, set by IterativeDeepeningPlay
+    int depth = 0;
+
+    TranspositionStatistics table;
+
+    // Nodes where a move was good enough to skip the rest, and how many of them stopped at the first move.
+    // The closer the two are, the better the move order.
+    long long cutoffs           = 0;
+    long long firstMoveCutoffs  = 0;
+
+    // Times the root was searched, more than once per depth when the window missed the score
+    long long rootSearches      = 0;
+
+    // Every depth AlphaBetaPlay or IterativeDeepeningPlay finished, in order. Not added up by Add.
+    std::vector<IterationStatistics> iterations;
+
+    // Sum of the scores MaximizePlay and MinimizePlay saw, used to adapt the minimax depth
+    float aiScoreTotal      = 0;
+    int aiScoreCount        = 0;
+    float playerScoreTotal  = 0;
+    int playerScoreCount    = 0;
+
+    // Adds the counters of another search, like one of the threads of a parallel search
+    void Add(const SearchStatistics& other);
+
+    // 0 to 1
+    float GetFirstMoveCutoffRate() const;
+
+    // The counters and the iterations as one JSON object, on one line
+    std::string ToJson() const;
+};
+
+// What the search learned about good moves so far, used to try them early in other positions.
+// Every search thread keeps its own.
+struct MoveHeuristics
+{
+    // Per ply (coins on the board), the last two columns that cut the search off
+    int8_t killers[ConnectFourBoard::ROWS * ConnectFourBoard::COLUMNS + 1][2];
+
+    // Per player and cell, the remaining depth squared of every cutoff the move caused
+    int32_t history[2][64];
+
+    MoveHeuristics();
+    void Clear();
+};
+
+// Everything a search needs next to the board
+struct SearchContext
+{
+    SearchStatistics statistics;
+
+    // Optional, searched positions are remembered here
+    TranspositionTable* transpositionTable = nullptr;
+
+    // Threads that search the root moves and their replies side by side, sharing the transposition table.
+    // 1 keeps the search on the calling thread. Any amount of threads finds the same column and score.
+    int threadCount = 1;
+
+    // Optional, the search gives up once this point in time has passed and sets aborted.
+    // The result of an aborted search is meaningless.
+    bool useDeadline = false;
+    std::chrono::steady_clock::time_point deadline;
+    bool aborted = false;
+
+    // Optional, set from another thread to stop the search. It sets aborted, like the deadline.
+    const std::atomic<bool>* cancelled = nullptr;
+
+    // After the transposition table's move, try the killer moves of the ply and then the moves with the best
+    // history. Off keeps the plain center first order. Either way the search finds the same column and score.
+    bool useMoveHeuristics = true;
+    MoveHeuristics heuristics;
+
+    // A position and its mirror image share one transposition table entry, so the table holds twice
+    // the positions. Off by default, a board where both players have four in a row is scored by the
+    // first complete window and that isn't the same for the mirror image. Such boards only come up
+    // after a won game, the moves searched before them hardly ever change.
+    bool useMirrorSymmetry = false;
+
+    // How the root window is picked, see SearchWindow. The narrow windows start from the score two depths before
+    // in statistics.iterations, which are taken to be of this position like they are for IterativeDeepeningPlay
+    // or AlphaBetaPlay called one depth at a time, else from the table's score. Without a table MTDF searches a full window.
+    SearchWindow window = SearchWindow::FULL;
+
+    // Half the width of the first aspiration window, in board score points
+    int aspirationWindow = 4;
+
+    // How the alpha-beta searches score the leaves. The scores of both don't mix, use a table for one only.
+    Evaluation evaluation = Evaluation::WINDOW_COUNT;
+
+    // PatternPoints of the board being searched, kept up to date move by move. Set by the root of the search.
+    int patternPoints = 0;
+};
+
+// All searches play their moves on the board they are given and take them back again with UndoCoin,
+// the board is the same afterwards.
+
+// Plain minimax, the AI maximizes and the human minimizes the board score. Optional cancelled, set from
+// another thread to stop the search, the result is meaningless then.
+ColumnScore MaximizePlay(ConnectFourBoard& board, int depth, SearchStatistics& statistics, const std::atomic<bool>* cancelled = nullptr);
+ColumnScore MinimizePlay(ConnectFourBoard& board, int depth, SearchStatistics& statistics, const std::atomic<bool>* cancelled = nullptr);
+
+// Negamax with alpha-beta pruning, trying the transposition table's move first, see SearchContext::useMoveHeuristics.
+// Returns the same column and score as MaximizePlay (player == AI) or MinimizePlay (player == HUMAN), those
+// only know SimpleScoring so that holds for SearchContext::evaluation WINDOW_COUNT
+ColumnScore AlphaBetaPlay(ConnectFourBoard& board, int depth, Player player, SearchContext& context);
+
+// Searches one depth deeper at a time until the time budget (in milliseconds) runs out or maxDepth is reached.
+// Returns the move of the deepest search that finished, every search tries the move of the one before it first.
+ColumnScore IterativeDeepeningPlay(ConnectFourBoard& board, Player player, int maxDepth, float timeBudget, SearchContext& context);
+
+// Score of the board for the player to move, searched inside the window [alpha, beta]
+int Negamax(ConnectFourBoard& board, int depth, int alpha, int beta, Player player, SearchContext& context);
+
+// The best move the transposition table remembers for the position, NIL when it doesn't know the position
+int GetTableMove(ConnectFourBoard& board, Player player, const TranspositionTable& table);
+
+// Runs the selected search for the AI. Not for MONTE_CARLO, which doesn't search to a depth
+ColumnScore SearchPlay(SearchAlgorithm algorithm, ConnectFourBoard& board, int depth, SearchContext& context);
+
+const char* GetSearchAlgorithmName(SearchAlgorithm algorithm);
+const char* GetSearchWindowName(SearchWindow window);
+
+#endif
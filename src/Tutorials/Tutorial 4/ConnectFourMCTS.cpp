@@ -0,0 +1,345 @@
+#include "ConnectFourMCTS.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const int COLUMNS = ConnectFourBoard::COLUMNS;
+    const int CELLS = ConnectFourBoard::ROWS * ConnectFourBoard::COLUMNS;
+
+    // Every thread on its way down counts as this many lost playouts until its playout is in
+    const int VIRTUAL_LOSS = 3;
+
+    // Looking at the clock every iteration would cost more than the playouts themselves
+    const int ITERATIONS_BETWEEN_CLOCK_CHECKS = 64;
+
+    enum NodeState
+    {
+        UNEXPANDED  = 0,
+        EXPANDING   = 1,    // A thread is adding the children
+        EXPANDED    = 2,
+    };
+
+    enum Outcome
+    {
+        UNDECIDED   = 0,
+        MOVER_WON   = 1,    // The move into this node won the game
+        DRAW        = 2,    // The move into this node filled the board
+    };
+
+    struct Node
+    {
+        // Playouts through the node, with the virtual losses of playouts still going on
+        std::atomic<int> visits;
+
+        // Half points for the player that moved into the node, 2 for a win and 1 for a draw
+        std::atomic<int> score;
+
+        std::atomic<int> state;
+        int firstChild;
+        int8_t childCount;
+        int8_t column;
+        int8_t outcome;
+    };
+
+    Player Opponent(Player player)
+    {
+        return player == Player::AI ? Player::HUMAN : Player::AI;
+    }
+
+    // xorshift64*, every thread has its own
+    struct Random
+    {
+        uint64_t state;
+
+        explicit Random(uint64_t seed) : state(seed ? seed : 1) {}
+
+        uint32_t Next()
+        {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return (uint32_t)((state * 0x2545F4914F6CDD1DULL) >> 32);
+        }
+    };
+
+    class Tree
+    {
+    public:
+        Tree(int capacity) : nodes(new Node[capacity]), capacity(capacity), used(0) {}
+
+        // Index of the first of count new nodes, NIL when the tree is full
+        int Allocate(int count)
+        {
+            int first = used.fetch_add(count);
+            return first + count <= capacity ? first : NIL;
+        }
+
+        Node& operator[](int index) { return nodes[index]; }
+
+        int GetNodeCount() const
+        {
+            int count = used.load();
+            return count < capacity ? count : capacity;
+        }
+
+    private:
+        std::unique_ptr<Node[]> nodes;
+        int capacity;
+        std::atomic<int> used;
+    };
+
+    void ResetNode(Node& node, int column, int outcome)
+    {
+        node.visits.store(0, std::memory_order_relaxed);
+        node.score.store(0, std::memory_order_relaxed);
+        node.state.store(UNEXPANDED, std::memory_order_relaxed);
+        node.firstChild = NIL;
+        node.childCount = 0;
+        node.column = (int8_t)column;
+        node.outcome = (int8_t)outcome;
+    }
+
+    // Adds a child for every column the player can drop a coin in. False when the tree is full.
+    bool Expand(Tree& tree, Node& node, ConnectFourBoard& board, Player player)
+    {
+        int columns[COLUMNS];
+        int outcomes[COLUMNS];
+        int count = 0;
+
+        for (int column = 0; column < COLUMNS; column++)
+        {
+            if (!board.DropCoin(column, player)) continue;
+
+            int outcome = UNDECIDED;
+            if (ConnectFourBoard::FourInARow(board.GetCoins(player)))   outcome = MOVER_WON;
+            else if (board.IsFinished())                                outcome = DRAW;
+
+            board.UndoCoin(column);
+
+            columns[count] = column;
+            outcomes[count] = outcome;
+            count++;
+        }
+
+        int first = tree.Allocate(count);
+        if (first == NIL) return false;
+
+        for (int i = 0; i < count; i++) ResetNode(tree[first + i], columns[i], outcomes[i]);
+
+        node.firstChild = first;
+        node.childCount = (int8_t)count;
+        node.state.store(EXPANDED, std::memory_order_release);
+        return true;
+    }
+
+    // UCT, the child with the best win rate plus a bonus for being looked at less
+    int SelectChild(Tree& tree, Node& node, float exploration)
+    {
+        float logVisits = std::log((float)node.visits.load(std::memory_order_relaxed) + 1.0f);
+
+        int best = node.firstChild;
+        float bestValue = -1.0f;
+
+        for (int i = 0; i < node.childCount; i++)
+        {
+            Node& child = tree[node.firstChild + i];
+            int visits = child.visits.load(std::memory_order_relaxed);
+
+            // Everything gets tried once first
+            if (visits == 0) return node.firstChild + i;
+
+            float winRate = child.score.load(std::memory_order_relaxed) / (2.0f * visits);
+            float value = winRate + exploration * std::sqrt(logVisits / visits);
+
+            if (value > bestValue)
+            {
+                bestValue = value;
+                best = node.firstChild + i;
+            }
+        }
+
+        return best;
+    }
+
+    // Cells the coins would get four in a row with, out of the cells that can be played
+    Bitboard WinningMoves(Bitboard coins, Bitboard playable)
+    {
+        Bitboard result = 0;
+
+        for (Bitboard cells = playable; cells; cells &= cells - 1)
+        {
+            Bitboard cell = cells & (~cells + 1);
+            if (ConnectFourBoard::FourInARow(coins | cell)) result |= cell;
+        }
+
+        return result;
+    }
+
+    // Plays random moves until the game is over, but never misses a win or a block in one.
+    // Returns the winner, or NIL for a draw.
+    int Playout(ConnectFourBoard& board, Player player, Random& random)
+    {
+        Bitboard bottomRow = 0;
+        for (int column = 0; column < COLUMNS; column++) bottomRow |= ConnectFourBoard::BottomMask(column);
+        Bitboard boardMask = bottomRow * ((Bitboard(1) << ConnectFourBoard::ROWS) - 1);
+
+        while (board.GetNumberOfMoves() < CELLS)
+        {
+            Bitboard playable = (board.GetHeightMask() + bottomRow) & boardMask;
+
+            Bitboard moves = WinningMoves(board.GetCoins(player), playable);
+            if (moves) return player;
+
+            moves = WinningMoves(board.GetCoins(Opponent(player)), playable);
+            if (moves == 0) moves = playable;
+
+            // A random one of the moves
+            int pick = random.Next() % ConnectFourBoard::CountCoins(moves);
+            for (int i = 0; i < pick; i++) moves &= moves - 1;
+
+            Bitboard cell = moves & (~moves + 1);
+            board.DropCoin(ConnectFourBoard::CountCoins(cell - 1) / ConnectFourBoard::COLUMN_HEIGHT, player);
+
+            player = Opponent(player);
+        }
+
+        return NIL;
+    }
+}
+
+MonteCarloResult MonteCarloPlay(const ConnectFourBoard& board, Player player, const MonteCarloSettings& settings)
+{
+    MonteCarloResult result;
+
+    if (board.IsFinished() || ConnectFourBoard::FourInARow(board.GetCoins(Player::HUMAN)) ||
+        ConnectFourBoard::FourInARow(board.GetCoins(Player::AI))) return result;
+
+    Tree tree(settings.nodeLimit > COLUMNS + 1 ? settings.nodeLimit : COLUMNS + 1);
+
+    // The root is the move the opponent made into this position
+    int root = tree.Allocate(1);
+    ResetNode(tree[root], NIL, UNDECIDED);
+    {
+        ConnectFourBoard rootBoard = board;
+        Expand(tree, tree[root], rootBoard, player);
+    }
+
+    bool useDeadline = settings.timeBudget > 0.0f;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(settings.timeBudget));
+
+    // Without any budget the search would never end
+    long long iterationLimit = settings.iterations > 0 || useDeadline ? settings.iterations : 1;
+
+    std::atomic<long long> iterationsStarted(0);
+    std::atomic<bool> outOfTime(false);
+
+    auto work = [&](int threadIndex)
+    {
+        Random random(0x9E3779B97F4A7C15ULL * (threadIndex + 1));
+        int path[CELLS + 2];
+
+        for (long long iteration = 0; ; iteration++)
+        {
+            if (iterationLimit > 0 && iterationsStarted.fetch_add(1) >= iterationLimit) return;
+
+            if (useDeadline && iteration % ITERATIONS_BETWEEN_CLOCK_CHECKS == 0 && std::chrono::steady_clock::now() >= deadline)
+                outOfTime = true;
+            if (outOfTime) return;
+            if (settings.cancelled && settings.cancelled->load(std::memory_order_relaxed)) return;
+
+            ConnectFourBoard playoutBoard = board;
+            Player toMove = player;
+
+            int length = 0;
+            int current = root;
+            path[length++] = current;
+            tree[current].visits.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+
+            // Down the tree to a node that hasn't got children yet, that one grows by one level
+            bool expanded = false;
+            while (tree[current].outcome == UNDECIDED && !expanded)
+            {
+                Node& node = tree[current];
+
+                if (node.state.load(std::memory_order_acquire) != EXPANDED)
+                {
+                    // Another thread is busy with this node, play out from here
+                    int expected = UNEXPANDED;
+                    if (!node.state.compare_exchange_strong(expected, EXPANDING)) break;
+
+                    if (!Expand(tree, node, playoutBoard, toMove))
+                    {
+                        node.state.store(UNEXPANDED, std::memory_order_release);
+                        break;
+                    }
+
+                    expanded = true;
+                }
+
+                current = SelectChild(tree, node, settings.exploration);
+                path[length++] = current;
+                tree[current].visits.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+
+                playoutBoard.DropCoin(tree[current].column, toMove);
+                toMove = Opponent(toMove);
+            }
+
+            int winner;
+            if      (tree[current].outcome == MOVER_WON)    winner = Opponent(toMove);
+            else if (tree[current].outcome == DRAW)         winner = NIL;
+            else                                            winner = Playout(playoutBoard, toMove, random);
+
+            // Back up, taking the virtual losses away again. The player that moved into a node alternates,
+            // the last node on the path was moved into by the opponent of the player to move there.
+            Player mover = Opponent(toMove);
+            for (int i = length - 1; i >= 0; i--)
+            {
+                Node& node = tree[path[i]];
+                node.visits.fetch_add(1 - VIRTUAL_LOSS, std::memory_order_relaxed);
+
+                if (winner == NIL)          node.score.fetch_add(1, std::memory_order_relaxed);
+                else if (winner == mover)   node.score.fetch_add(2, std::memory_order_relaxed);
+
+                mover = Opponent(mover);
+            }
+        }
+    };
+
+    int threadCount = settings.threadCount > 1 ? settings.threadCount : 1;
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++) threads.push_back(std::thread(work, i));
+
+    // The calling thread is the first worker
+    work(0);
+
+    for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+    // The most played out column, it has the most reliable win rate
+    Node& rootNode = tree[root];
+    int bestVisits = -1;
+
+    for (int i = 0; i < rootNode.childCount; i++)
+    {
+        Node& child = tree[rootNode.firstChild + i];
+        int visits = child.visits.load();
+
+        if (visits > bestVisits)
+        {
+            bestVisits = visits;
+            result.column = child.column;
+            result.winRate = visits > 0 ? child.score.load() / (2.0f * visits) : 0.0f;
+        }
+    }
+
+    result.iterations = rootNode.visits.load();
+    result.nodes = tree.GetNodeCount();
+    return result;
+}
@@ -0,0 +1,45 @@
+#ifndef CONNECT_FOUR_MCTS_H
+#define CONNECT_FOUR_MCTS_H
+
+#include "ConnectFour.h"
+#include "ConnectFourAI.h"
+
+#include <atomic>
+
+struct MonteCarloSettings
+{
+    // The search stops at whichever budget runs out first, 0 means no limit (but set at least one)
+    long long iterations    = 100000;
+    float timeBudget        = 0.0f; // Milliseconds
+
+    // Threads that grow the same tree, every thread puts a virtual loss on the path it is playing out
+    // so the others try something else in the meantime
+    int threadCount         = 1;
+
+    // UCT exploration constant, higher looks at more moves, lower plays out the best one more often
+    float exploration       = 1.0f;
+
+    // Nodes the tree can have, after that the leaves are played out without growing the tree
+    int nodeLimit           = 1 << 20;
+
+    // Optional, set from another thread to stop the search early. The move is the best one so far.
+    const std::atomic<bool>* cancelled = nullptr;
+};
+
+struct MonteCarloResult
+{
+    int column              = NIL;
+
+    // Wins plus half the draws, per playout through the chosen column, for the player that moves
+    float winRate           = 0.0f;
+
+    long long iterations    = 0;
+    int nodes               = 0;
+};
+
+// Monte Carlo tree search (UCT). Plays random games from the position, the first moves of the games
+// grow into a tree that tries good moves more often. Playouts take a winning move when there is one.
+// The column played out most often is the move.
+MonteCarloResult MonteCarloPlay(const ConnectFourBoard& board, Player player, const MonteCarloSettings& settings);
+
+#endif
@@ -0,0 +1,371 @@
+#include "ConnectFourSolver.h"
+
+namespace
+{
+    const int ROWS = ConnectFourBoard::ROWS;
+    const int COLUMNS = ConnectFourBoard::COLUMNS;
+    const int H1 = ConnectFourBoard::COLUMN_HEIGHT;
+    const int CELLS = ROWS * COLUMNS;
+
+    // Scores are 43 minus the amount of coins after the winning one, so a faster win scores higher
+    const int WIN_SCORE_BASE = CELLS + 1;
+
+    struct BoardMasks
+    {
+        Bitboard bottom = 0;    // Bottom cell of every column
+        Bitboard board = 0;     // Every cell, without the spare bits
+
+        BoardMasks()
+        {
+            for (int column = 0; column < COLUMNS; column++)
+            {
+                bottom |= ConnectFourBoard::BottomMask(column);
+                board |= ConnectFourBoard::ColumnMask(column);
+            }
+        }
+    };
+
+    const BoardMasks masks;
+
+    // Looking at the clock every node would cost more than the solving
+    const long long NODES_BETWEEN_CLOCK_CHECKS = 1024;
+
+    // The deadline passed or somebody cancelled the solve
+    bool OutOfTime(SolverContext& context)
+    {
+        if (context.aborted) return true;
+
+        if (context.nodes % NODES_BETWEEN_CLOCK_CHECKS != 0) return false;
+
+        if (context.useDeadline && std::chrono::steady_clock::now() >= context.deadline)
+        {
+            context.aborted = true;
+        }
+
+        if (context.cancelled && context.cancelled->load(std::memory_order_relaxed))
+        {
+            context.aborted = true;
+        }
+
+        return context.aborted;
+    }
+
+    // Center first, the same as the searches
+    const int columnOrder[COLUMNS] = { 3, 2, 4, 1, 5, 0, 6 };
+
+    // Only what the solver needs, the coins of the player to move and all coins
+    struct SolverPosition
+    {
+        Bitboard current;
+        Bitboard mask;
+        int moves;
+
+        Bitboard Possible() const
+        {
+            return (mask + masks.bottom) & masks.board;
+        }
+
+        // The player to move drops a coin, the cell is one of Possible()
+        SolverPosition Play(Bitboard move) const
+        {
+            // The coins switch sides, the opponent is the one to move afterwards
+            SolverPosition next;
+            next.current = current ^ mask;
+            next.mask = mask | move;
+            next.moves = moves + 1;
+            return next;
+        }
+
+        Bitboard WinningCells() const
+        {
+            return WinningCells(current, mask);
+        }
+
+        Bitboard OpponentWinningCells() const
+        {
+            return WinningCells(current ^ mask, mask);
+        }
+
+        bool CanWinNext() const
+        {
+            return (WinningCells() & Possible()) != 0;
+        }
+
+        // The moves that don't hand the opponent a win on the next move, 0 when every move does
+        Bitboard PossibleNonLosingMoves() const
+        {
+            Bitboard possible = Possible();
+            Bitboard opponentWins = OpponentWinningCells();
+            Bitboard forced = possible & opponentWins;
+
+            if (forced)
+            {
+                // Two cells to block, one of them stays open
+                if (forced & (forced - 1)) return 0;
+                possible = forced;
+            }
+
+            // Don't drop a coin right under a cell the opponent wins with
+            return possible & ~(opponentWins >> 1);
+        }
+
+        // More threats after the move makes it more likely to be good
+        int MoveScore(Bitboard move) const
+        {
+            return ConnectFourBoard::CountCoins(WinningCells(current | move, mask));
+        }
+
+        // Empty cells that would give the coins four in a row
+        static Bitboard WinningCells(Bitboard coins, Bitboard mask)
+        {
+            // Vertical, three coins right below
+            Bitboard result = (coins << 1) & (coins << 2) & (coins << 3);
+
+            // Horizontal and both diagonals, the empty cell can be any of the four
+            const int shifts[3] = { H1, H1 - 1, H1 + 1 };
+            for (int i = 0; i < 3; i++)
+            {
+                int shift = shifts[i];
+
+                Bitboard pairs = (coins << shift) & (coins << (2 * shift));
+                result |= pairs & (coins << (3 * shift));
+                result |= pairs & (coins >> shift);
+
+                pairs = (coins >> shift) & (coins >> (2 * shift));
+                result |= pairs & (coins << shift);
+                result |= pairs & (coins >> (3 * shift));
+            }
+
+            return result & (masks.board ^ mask);
+        }
+    };
+
+    uint64_t GetSolverKey(const SolverPosition& position)
+    {
+        // Same idea as ConnectFourBoard::GetPositionKey, the player to move follows from the amount of coins
+        return position.current + position.mask + masks.bottom;
+    }
+
+    // Negamax with alpha-beta pruning. The player to move can't win with this move, the caller checked
+    // that or the opponent's last move had to block it.
+    int Negamax(const SolverPosition& position, int alpha, int beta, SolverContext& context)
+    {
+        context.nodes++;
+
+        if (OutOfTime(context)) return 0;
+
+        Bitboard next = position.PossibleNonLosingMoves();
+
+        // Whatever the move, the opponent wins right after it
+        if (next == 0) return -(WIN_SCORE_BASE - (position.moves + 2));
+
+        // Two cells left and neither player can win with them
+        if (position.moves >= CELLS - 2) return 0;
+
+        // The opponent can't win with the next move, at best with the one after
+        int minimum = -(WIN_SCORE_BASE - (position.moves + 4));
+        if (alpha < minimum)
+        {
+            alpha = minimum;
+            if (alpha >= beta) return alpha;
+        }
+
+        // This move doesn't win, at best the next one does
+        int maximum = WIN_SCORE_BASE - (position.moves + 3);
+        if (beta > maximum)
+        {
+            beta = maximum;
+            if (alpha >= beta) return beta;
+        }
+
+        uint64_t key = GetSolverKey(position);
+        int emptyCells = CELLS - position.moves;
+        int tableMove = NIL;
+
+        if (context.transpositionTable)
+        {
+            TranspositionEntry entry;
+            if (context.transpositionTable->Probe(key, entry, context.tableStatistics))
+            {
+                tableMove = entry.bestMove;
+
+                if (entry.bound == Bound::EXACT) return entry.score;
+                if (entry.bound == Bound::LOWER && entry.score >= beta) return entry.score;
+                if (entry.bound == Bound::UPPER && entry.score <= alpha) return entry.score;
+
+                if (entry.bound == Bound::LOWER && entry.score > alpha) alpha = entry.score;
+                if (entry.bound == Bound::UPPER && entry.score < beta) beta = entry.score;
+            }
+        }
+
+        int windowAlpha = alpha;
+
+        // Moves with the most new threats first, the table's move before all of them,
+        // center columns first between equal ones
+        int orderedColumns[COLUMNS];
+        int orderedScores[COLUMNS];
+        int count = 0;
+
+        for (int i = 0; i < COLUMNS; i++)
+        {
+            int column = columnOrder[i];
+            Bitboard move = next & ConnectFourBoard::ColumnMask(column);
+            if (move == 0) continue;
+
+            int score = column == tableMove ? 1000 : position.MoveScore(move);
+
+            int j = count++;
+            for (; j > 0 && orderedScores[j - 1] < score; j--)
+            {
+                orderedColumns[j] = orderedColumns[j - 1];
+                orderedScores[j] = orderedScores[j - 1];
+            }
+
+            orderedColumns[j] = column;
+            orderedScores[j] = score;
+        }
+
+        int bestMove = NIL;
+
+        for (int i = 0; i < count; i++)
+        {
+            int column = orderedColumns[i];
+            SolverPosition child = position.Play(next & ConnectFourBoard::ColumnMask(column));
+
+            int score = -Negamax(child, -beta, -alpha, context);
+
+            // Nothing found after the abort can be trusted, don't store it
+            if (context.aborted) return 0;
+
+            if (score >= beta)
+            {
+                if (context.transpositionTable)
+                    context.transpositionTable->Store(key, emptyCells, score, Bound::LOWER, column, context.tableStatistics);
+
+                return score;
+            }
+
+            if (score > alpha)
+            {
+                alpha = score;
+                bestMove = column;
+            }
+        }
+
+        if (context.transpositionTable)
+        {
+            Bound bound = alpha > windowAlpha ? Bound::EXACT : Bound::UPPER;
+            context.transpositionTable->Store(key, emptyCells, alpha, bound, bestMove, context.tableStatistics);
+        }
+
+        return alpha;
+    }
+
+    // The exact score, narrowed down with null-window searches. A search with a window of one only
+    // answers "better than this or not", but it answers a lot faster than a full window.
+    int Solve(const SolverPosition& position, SolverContext& context)
+    {
+        if (position.CanWinNext()) return WIN_SCORE_BASE - (position.moves + 1);
+
+        int minimum = -(WIN_SCORE_BASE - (position.moves + 2));
+        int maximum = WIN_SCORE_BASE - (position.moves + 3);
+
+        while (minimum < maximum)
+        {
+            // Halve the range, but look around zero first, most positions are close to a draw
+            int middle = minimum + (maximum - minimum) / 2;
+            if (middle <= 0 && minimum / 2 < middle) middle = minimum / 2;
+            else if (middle >= 0 && maximum / 2 > middle) middle = maximum / 2;
+
+            int result = Negamax(position, middle, middle + 1, context);
+            if (context.aborted) return 0;
+
+            if (result <= middle)   maximum = result;
+            else                    minimum = result;
+        }
+
+        return minimum;
+    }
+}
+
+SolverResult SolvePosition(const ConnectFourBoard& board, Player player, SolverContext& context)
+{
+    SolverResult result;
+
+    SolverPosition position;
+    position.current = board.GetCoins(player);
+    position.mask = board.GetHeightMask();
+    position.moves = board.GetNumberOfMoves();
+
+    Player opponent = player == Player::AI ? Player::HUMAN : Player::AI;
+
+    // Already over, nothing to play
+    if (ConnectFourBoard::FourInARow(board.GetCoins(opponent)))
+    {
+        result.value = -1;
+        result.score = -(WIN_SCORE_BASE - position.moves);
+        return result;
+    }
+    if (ConnectFourBoard::FourInARow(board.GetCoins(player)))
+    {
+        result.value = 1;
+        result.score = WIN_SCORE_BASE - position.moves;
+        return result;
+    }
+    if (position.moves == CELLS) return result;
+
+    Bitboard possible = position.Possible();
+    Bitboard winningCells = position.WinningCells();
+
+    // Winning right away can't be beaten
+    for (int i = 0; i < COLUMNS; i++)
+    {
+        int column = columnOrder[i];
+        if (possible & winningCells & ConnectFourBoard::ColumnMask(column))
+        {
+            result.column = column;
+            result.value = 1;
+            result.distance = 1;
+            result.score = WIN_SCORE_BASE - (position.moves + 1);
+            return result;
+        }
+    }
+
+    int bestScore = -WIN_SCORE_BASE;
+
+    for (int i = 0; i < COLUMNS; i++)
+    {
+        int column = columnOrder[i];
+        Bitboard move = possible & ConnectFourBoard::ColumnMask(column);
+        if (move == 0) continue;
+
+        int score = -Solve(position.Play(move), context);
+        if (context.aborted) return result;
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+            result.column = column;
+        }
+    }
+
+    result.score = bestScore;
+
+    if (bestScore > 0)
+    {
+        result.value = 1;
+        result.distance = (WIN_SCORE_BASE - bestScore) - position.moves;
+    }
+    else if (bestScore < 0)
+    {
+        result.value = -1;
+        result.distance = (WIN_SCORE_BASE + bestScore) - position.moves;
+    }
+    else
+    {
+        result.value = 0;
+        result.distance = CELLS - position.moves;
+    }
+
+    return result;
+}
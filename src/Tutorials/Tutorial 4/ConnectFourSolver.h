@@ -0,0 +1,54 @@
+#ifndef CONNECT_FOUR_SOLVER_H
+#define CONNECT_FOUR_SOLVER_H
+
+#include "ConnectFour.h"
+#include "ConnectFourAI.h"
+#include "TranspositionTable.h"
+
+#include <atomic>
+#include <chrono>
+
+// The outcome of a position when both players play perfectly
+struct SolverResult
+{
+    // Column to play, NIL when the game is already over
+    int column = NIL;
+
+    // 1 the player wins, 0 draw, -1 the player loses
+    int value = 0;
+
+    // Coins dropped (by both players) until the winning coin is in, or until the board is full for a draw.
+    // The winner wins as fast as possible, the loser holds out as long as possible.
+    int distance = 0;
+
+    // Solver score, 43 minus the amount of coins on the board after the winning coin.
+    // Positive when the player wins, negative when the player loses, 0 for a draw.
+    int score = 0;
+};
+
+struct SolverContext
+{
+    // Positions visited
+    long long nodes = 0;
+
+    // Optional, but without one only positions close to the end are solved in reasonable time.
+    // Solver scores mean something else than search scores, don't share a table with the searches.
+    TranspositionTable* transpositionTable = nullptr;
+    TranspositionStatistics tableStatistics;
+
+    // Optional, the solver gives up once this point in time has passed and sets aborted.
+    // The result of an aborted solve is meaningless.
+    bool useDeadline = false;
+    std::chrono::steady_clock::time_point deadline;
+    bool aborted = false;
+
+    // Optional, set from another thread to stop the solver. It sets aborted, like the deadline.
+    const std::atomic<bool>* cancelled = nullptr;
+};
+
+// Plays the game out to the end, exact instead of guessing with SimpleScoring. Only fast enough
+// with few empty cells left, about 28 take a few hundredths of a second with a transposition table.
+// A solve stopped by the deadline or cancel sets aborted and its result is meaningless.
+SolverResult SolvePosition(const ConnectFourBoard& board, Player player, SolverContext& context);
+
+#endif
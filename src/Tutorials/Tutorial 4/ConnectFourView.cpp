@@ -0,0 +1,131 @@
+#include "ConnectFourView.h"
+
+#include <SOIL.h>
+#include <string>
+#include <GLFW/glfw3.h> // GLFW helper library
+
+using namespace glm;
+
+ConnectFourView::ConnectFourView()
+{
+    animatedCoins = 0;
+}
+
+void ConnectFourView::Initialize()
+{
+    fallingTokens.clear();
+    animatedCoins = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        std::string coinLocation = std::string(ASSETS) + std::string("Images/Coin") +
+            std::to_string(i) + std::string(".png");
+
+        coinTexture[i] = SOIL_load_OGL_texture(
+            coinLocation.c_str(),
+            SOIL_LOAD_AUTO,
+            SOIL_CREATE_NEW_ID,
+            SOIL_FLAG_INVERT_Y | SOIL_FLAG_NTSC_SAFE_RGB | SOIL_FLAG_COMPRESS_TO_DXT
+        );
+
+        glBindTexture(GL_TEXTURE_2D, coinTexture[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    }
+
+    background = SOIL_load_OGL_texture(
+        ASSETS"Images/Background.png",
+        SOIL_LOAD_AUTO,
+        SOIL_CREATE_NEW_ID,
+        SOIL_FLAG_INVERT_Y | SOIL_FLAG_NTSC_SAFE_RGB | SOIL_FLAG_COMPRESS_TO_DXT
+    );
+
+    glBindTexture(GL_TEXTURE_2D, background);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+}
+
+void ConnectFourView::Observe(const ConnectFourBoard& board)
+{
+    const int ROWS = ConnectFourBoard::ROWS;
+    const int COLUMNS = ConnectFourBoard::COLUMNS;
+
+    Bitboard heightMask = board.GetHeightMask();
+
+    // Coins that were taken back (or the whole board on a reset) stop falling
+    if (animatedCoins & ~heightMask)
+    {
+        for (auto itr = fallingTokens.begin(); itr != fallingTokens.end();)
+        {
+            if (heightMask & ConnectFourBoard::CellBit((int)itr->x, (int)itr->y)) itr++;
+            else itr = fallingTokens.erase(itr);
+        }
+
+        animatedCoins &= heightMask;
+    }
+
+    // Coins dropped since the last look start falling now
+    for (int column = 0; column < COLUMNS; column++)
+    {
+        for (int row = ROWS - 1; row >= 0; row--)
+        {
+            Bitboard cell = ConnectFourBoard::CellBit(row, column);
+            if (!(heightMask & cell)) break;
+            if (animatedCoins & cell) continue;
+
+            bool isHuman = (board.GetCoins(Player::HUMAN) & cell) != 0;
+            fallingTokens.push_back(glm::vec4(row, column, glfwGetTime(), isHuman ? 0.0f : 1.0f));
+            animatedCoins |= cell;
+        }
+    }
+}
+
+void ConnectFourView::DrawBoard(const ConnectFourBoard& board, std::function<void(vec2, vec2)> drawQuadFunction)
+{
+    const int ROWS = ConnectFourBoard::ROWS;
+    const int COLUMNS = ConnectFourBoard::COLUMNS;
+
+    vec2 coinSize = vec2(PIXEL_WIDTH, PIXEL_HEIGHT) / vec2((float)COLUMNS, (float)ROWS);
+    vec2 coinBias = coinSize / 2.0f;
+
+    glBindTexture(GL_TEXTURE_2D, background);
+    for (int i = 0; i < ROWS; i++)
+    {
+        for (int j = 0; j < COLUMNS; j++)
+        {
+            vec2 pos = coinBias + (coinSize * vec2(j, ROWS - 1 - i));
+
+            drawQuadFunction(pos, coinSize);
+        }
+    }
+
+    Observe(board);
+
+    // Once the game is decided the coins of the winning four turn gold
+    Bitboard winningLine = board.GetWinningLine();
+
+    for (auto itr = fallingTokens.begin(); itr != fallingTokens.end(); itr++)
+    {
+        vec4 ft = (*itr);
+
+        int x = (int)ft.y;
+        int y = (int)ft.x;
+
+        float deltaTime = min(1.0f, (float)glfwGetTime() - ft.z + 0.25f);
+
+        const float a = 3.1415f * (4.0f * deltaTime - 1.0f);
+        float interp = 1.0f - abs(sin(a) / a);
+        {
+            if (winningLine & ConnectFourBoard::CellBit(y, x))  glBindTexture(GL_TEXTURE_2D, coinTexture[(int)winColor]);
+            else if (ft.w < 0.5f)                               glBindTexture(GL_TEXTURE_2D, coinTexture[(int)playerColor]);
+            else                                                glBindTexture(GL_TEXTURE_2D, coinTexture[(int)aiColor]);
+
+            vec2 posA = coinBias + (coinSize * vec2(x, ROWS * 2 - y));
+            vec2 posB = coinBias + (coinSize * vec2(x, ROWS - 1 - y));
+
+            vec2 position = mix(posA, posB, interp);
+
+            drawQuadFunction(position, coinSize);
+        }
+    }
+}
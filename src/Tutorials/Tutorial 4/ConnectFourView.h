@@ -0,0 +1,53 @@
+#ifndef CONNECT_FOUR_VIEW_H
+#define CONNECT_FOUR_VIEW_H
+
+#include "ConnectFour.h"
+
+#include <GL/gl3w.h>
+#include <functional>
+#include <GLM/glm.hpp>
+#include <vector>
+
+enum Color
+{
+    GOLD    = 0,
+    RED     = 1,
+    BLUE    = 2,
+    GREEN   = 3,
+};
+
+// Everything needed to draw a ConnectFourBoard, the board itself doesn't know it is being drawn.
+// Coins that show up on the board start falling, coins that disappear (undo or reset) stop being drawn.
+class ConnectFourView
+{
+public:
+    ConnectFourView();
+
+    // Loads the textures, needs the OpenGL context
+    void Initialize();
+
+    // Picks up the coins dropped or taken back since the last time the board was seen
+    void Observe(const ConnectFourBoard& board);
+
+    void DrawBoard(const ConnectFourBoard& board, std::function<void(glm::vec2, glm::vec2)> drawQuadFunction);
+
+public:
+    const static int PIXEL_WIDTH = 392;
+    const static int PIXEL_HEIGHT = 408;
+
+private:
+    // Row, column, time it started falling, 0 for a human coin and 1 for an AI coin
+    std::vector<glm::vec4> fallingTokens;
+
+    // Coins that are in fallingTokens
+    Bitboard animatedCoins;
+
+    GLuint coinTexture[4];
+    GLuint background;
+
+    const Color playerColor = Color::BLUE;
+    const Color aiColor     = Color::RED;
+    const Color winColor    = Color::GOLD;
+};
+
+#endif
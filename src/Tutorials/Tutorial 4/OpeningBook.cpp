@@ -0,0 +1,162 @@
+#include "OpeningBook.h"
+
+#include <algorithm>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+OpeningBook::OpeningBook()
+{
+    header = nullptr;
+    entries = nullptr;
+    view = nullptr;
+    viewSize = 0;
+
+#ifdef _WIN32
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = nullptr;
+#endif
+}
+
+OpeningBook::~OpeningBook()
+{
+    Close();
+}
+
+bool OpeningBook::Open(const char* path)
+{
+    Close();
+
+#ifdef _WIN32
+    fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(OpeningBookHeader))
+    {
+        Close();
+        return false;
+    }
+
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle)
+    {
+        Close();
+        return false;
+    }
+
+    view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    viewSize = (size_t)fileSize.QuadPart;
+#else
+    int file = open(path, O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat fileStatus;
+    if (fstat(file, &fileStatus) != 0 || fileStatus.st_size < (off_t)sizeof(OpeningBookHeader))
+    {
+        close(file);
+        return false;
+    }
+
+    viewSize = (size_t)fileStatus.st_size;
+    view = mmap(nullptr, viewSize, PROT_READ, MAP_SHARED, file, 0);
+    if (view == MAP_FAILED) view = nullptr;
+
+    // The mapping keeps the file alive by itself
+    close(file);
+#endif
+
+    if (!view)
+    {
+        Close();
+        return false;
+    }
+
+    const OpeningBookHeader* candidate = (const OpeningBookHeader*)view;
+
+    if (memcmp(candidate->magic, "C4BK", 4) != 0 || candidate->version != VERSION ||
+        candidate->evaluation > (uint32_t)Evaluation::PATTERNS ||
+        viewSize != sizeof(OpeningBookHeader) + (size_t)candidate->entryCount * sizeof(OpeningBookEntry))
+    {
+        Close();
+        return false;
+    }
+
+    header = candidate;
+    entries = (const OpeningBookEntry*)(header + 1);
+    return true;
+}
+
+void OpeningBook::Close()
+{
+#ifdef _WIN32
+    if (view) UnmapViewOfFile(view);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = nullptr;
+#else
+    if (view) munmap((void*)view, viewSize);
+#endif
+
+    header = nullptr;
+    entries = nullptr;
+    view = nullptr;
+    viewSize = 0;
+}
+
+bool OpeningBook::IsOpen() const
+{
+    return header != nullptr;
+}
+
+bool OpeningBook::Lookup(const ConnectFourBoard& board, Player player, ColumnScore& move) const
+{
+    if (!header || (uint32_t)board.GetNumberOfMoves() > header->maxPly) return false;
+
+    uint64_t key = GetKey(board, player);
+
+    const OpeningBookEntry* end = entries + header->entryCount;
+    const OpeningBookEntry* entry = std::lower_bound(entries, end, key,
+        [](const OpeningBookEntry& entry, uint64_t key) { return entry.key < key; });
+
+    if (entry == end || entry->key != key) return false;
+
+    move = ColumnScore(entry->column, entry->score);
+    return true;
+}
+
+uint32_t OpeningBook::GetEntryCount() const
+{
+    return header ? header->entryCount : 0;
+}
+
+uint32_t OpeningBook::GetMaxPly() const
+{
+    return header ? header->maxPly : 0;
+}
+
+uint32_t OpeningBook::GetDepth() const
+{
+    return header ? header->depth : 0;
+}
+
+Evaluation OpeningBook::GetEvaluation() const
+{
+    return header ? (Evaluation)header->evaluation : Evaluation::WINDOW_COUNT;
+}
+
+uint64_t OpeningBook::GetKey(const ConnectFourBoard& board, Player player)
+{
+    return board.GetPositionKey() | (player == Player::AI ? uint64_t(1) << 63 : 0);
+}
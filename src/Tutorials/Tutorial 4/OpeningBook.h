@@ -0,0 +1,84 @@
+#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+
+#include "ConnectFour.h"
+#include "ConnectFourAI.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// File layout, written by the "Connect Four Book Builder" tool
+//
+// [header][entry][entry]...[entry]
+//
+// The entries are sorted by key so a position is found with a binary search, straight in the
+// mapped file without reading it in.
+struct OpeningBookHeader
+{
+    char magic[4];          // "C4BK"
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t maxPly;        // Positions with up to this many coins are in the book
+    uint32_t depth;         // Alpha-beta depth the entries were searched to
+    uint32_t evaluation;    // Evaluation the entries were searched with
+};
+
+struct OpeningBookEntry
+{
+    uint64_t key;           // OpeningBook::GetKey
+    int32_t score;          // For the AI, like the searches return
+    int8_t column;
+    uint8_t padding[3];
+};
+
+static_assert(sizeof(OpeningBookHeader) == 24, "The book header is part of the file format");
+static_assert(sizeof(OpeningBookEntry) == 16, "The book entry is part of the file format");
+
+// A read-only view of a book file. The file is memory mapped, the operating system only reads the pages
+// a lookup touches and shares them between programs using the same book.
+class OpeningBook
+{
+public:
+    // 2 added the evaluation, older books aren't loaded
+    const static uint32_t VERSION = 2;
+
+    OpeningBook();
+    ~OpeningBook();
+
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    // False when the file is missing or isn't a book of this version
+    bool Open(const char* path);
+    void Close();
+
+    bool IsOpen() const;
+
+    // True and fills the move when the position is in the book
+    bool Lookup(const ConnectFourBoard& board, Player player, ColumnScore& move) const;
+
+    uint32_t GetEntryCount() const;
+    uint32_t GetMaxPly() const;
+    uint32_t GetDepth() const;
+
+    // The book's moves are what a search with this evaluation plays, don't mix them with the other one
+    Evaluation GetEvaluation() const;
+
+    // The same coins with a different player to move is a different entry
+    static uint64_t GetKey(const ConnectFourBoard& board, Player player);
+
+private:
+    const OpeningBookHeader* header;
+    const OpeningBookEntry* entries;
+
+    // The mapped file
+    const void* view;
+    size_t viewSize;
+
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+#endif
@@ -0,0 +1,274 @@
+#include "TranspositionCache.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    uint64_t Checksum(const TranspositionCacheEntry* entries, size_t count)
+    {
+        // FNV-1a, 64 bit
+        const uint8_t* bytes = (const uint8_t*)entries;
+        size_t size = count * sizeof(TranspositionCacheEntry);
+
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ULL;
+        }
+
+        return hash;
+    }
+
+    // A whole file mapped read-only, like the opening book
+    class MappedFile
+    {
+    public:
+        MappedFile(const char* path)
+        {
+#ifdef _WIN32
+            fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (fileHandle == INVALID_HANDLE_VALUE) return;
+
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) return;
+
+            mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mappingHandle) return;
+
+            view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+            if (view) size = (size_t)fileSize.QuadPart;
+#else
+            int file = open(path, O_RDONLY);
+            if (file < 0) return;
+
+            struct stat fileStatus;
+            if (fstat(file, &fileStatus) == 0 && fileStatus.st_size > 0)
+            {
+                void* mapped = mmap(nullptr, (size_t)fileStatus.st_size, PROT_READ, MAP_SHARED, file, 0);
+                if (mapped != MAP_FAILED)
+                {
+                    view = mapped;
+                    size = (size_t)fileStatus.st_size;
+                }
+            }
+
+            // The mapping keeps the file alive by itself
+            close(file);
+#endif
+        }
+
+        ~MappedFile()
+        {
+#ifdef _WIN32
+            if (view) UnmapViewOfFile(view);
+            if (mappingHandle) CloseHandle(mappingHandle);
+            if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+#else
+            if (view) munmap((void*)view, size);
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // The entries when the file is a cache for this board and evaluation, nullptr otherwise
+        const TranspositionCacheEntry* GetEntries(Evaluation evaluation, uint32_t& count) const
+        {
+            count = 0;
+            if (!view || size < sizeof(TranspositionCacheHeader)) return nullptr;
+
+            const TranspositionCacheHeader* header = (const TranspositionCacheHeader*)view;
+            const TranspositionCacheEntry* entries = (const TranspositionCacheEntry*)(header + 1);
+
+            if (memcmp(header->magic, "C4TT", 4) != 0 || header->version != TRANSPOSITION_CACHE_VERSION ||
+                header->evaluation != (uint8_t)evaluation ||
+                header->rows != ConnectFourBoard::ROWS || header->columns != ConnectFourBoard::COLUMNS ||
+                size != sizeof(TranspositionCacheHeader) + (size_t)header->entryCount * sizeof(TranspositionCacheEntry) ||
+                header->checksum != Checksum(entries, header->entryCount))
+            {
+                return nullptr;
+            }
+
+            count = header->entryCount;
+            return entries;
+        }
+
+    private:
+        const void* view = nullptr;
+        size_t size = 0;
+
+#ifdef _WIN32
+        HANDLE fileHandle = INVALID_HANDLE_VALUE;
+        HANDLE mappingHandle = nullptr;
+#endif
+    };
+
+    // Creates the file at its full size, maps it and copies the header and entries in
+    bool WriteMapped(const char* path, const TranspositionCacheHeader& header, const std::vector<TranspositionCacheEntry>& entries)
+    {
+        size_t entryBytes = entries.size() * sizeof(TranspositionCacheEntry);
+        size_t size = sizeof(header) + entryBytes;
+        bool written = false;
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        // The mapping grows the file to its size
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+        if (mapping)
+        {
+            void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+            if (view)
+            {
+                memcpy(view, &header, sizeof(header));
+                if (entryBytes > 0) memcpy((uint8_t*)view + sizeof(header), entries.data(), entryBytes);
+
+                written = FlushViewOfFile(view, size) != 0;
+                UnmapViewOfFile(view);
+            }
+
+            CloseHandle(mapping);
+        }
+
+        written = CloseHandle(file) != 0 && written;
+#else
+        int file = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (file < 0) return false;
+
+        if (ftruncate(file, (off_t)size) == 0)
+        {
+            void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+            if (view != MAP_FAILED)
+            {
+                memcpy(view, &header, sizeof(header));
+                if (entryBytes > 0) memcpy((uint8_t*)view + sizeof(header), entries.data(), entryBytes);
+
+                written = msync(view, size, MS_SYNC) == 0;
+                munmap(view, size);
+            }
+        }
+
+        written = close(file) == 0 && written;
+#endif
+
+        return written;
+    }
+
+    bool ReplaceFile(const char* from, const char* to)
+    {
+#ifdef _WIN32
+        return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        return rename(from, to) == 0;
+#endif
+    }
+}
+
+size_t LoadTranspositionCache(const char* path, Evaluation evaluation, TranspositionTable& table)
+{
+    MappedFile file(path);
+
+    uint32_t count;
+    const TranspositionCacheEntry* entries = file.GetEntries(evaluation, count);
+    if (!entries) return 0;
+
+    // Loaded entries belong to the generation before the first search, so the searches are free to replace them
+    TranspositionStatistics statistics;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const TranspositionCacheEntry& entry = entries[i];
+        table.Store(entry.key, entry.depth, entry.score, entry.bound, entry.bestMove, statistics);
+    }
+
+    return count;
+}
+
+bool SaveTranspositionCache(const char* path, Evaluation evaluation, const TranspositionTable& table,
+    int minDepth, size_t maxEntries, size_t& entryCount)
+{
+    std::vector<TranspositionCacheEntry> entries;
+
+    // What earlier games left in the file, it may hold positions the table has lost since
+    {
+        MappedFile file(path);
+
+        uint32_t count;
+        const TranspositionCacheEntry* oldEntries = file.GetEntries(evaluation, count);
+        if (oldEntries) entries.assign(oldEntries, oldEntries + count);
+    }
+
+    for (size_t i = 0; i < table.GetEntryCount(); i++)
+    {
+        uint64_t key;
+        TranspositionEntry slot;
+        if (!table.ReadSlot(i, key, slot) || slot.depth < minDepth) continue;
+
+        TranspositionCacheEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.key = key;
+        entry.score = slot.score;
+        entry.depth = slot.depth;
+        entry.bound = slot.bound;
+        entry.bestMove = slot.bestMove;
+        entries.push_back(entry);
+    }
+
+    // Deepest first per position, an exact score before a bound of the same depth. Only the first of a key stays.
+    std::sort(entries.begin(), entries.end(), [](const TranspositionCacheEntry& a, const TranspositionCacheEntry& b)
+    {
+        if (a.key != b.key) return a.key < b.key;
+        if (a.depth != b.depth) return a.depth > b.depth;
+        return (a.bound == Bound::EXACT) > (b.bound == Bound::EXACT);
+    });
+
+    entries.erase(std::unique(entries.begin(), entries.end(),
+        [](const TranspositionCacheEntry& a, const TranspositionCacheEntry& b) { return a.key == b.key; }), entries.end());
+
+    if (entries.size() > maxEntries)
+    {
+        std::stable_sort(entries.begin(), entries.end(),
+            [](const TranspositionCacheEntry& a, const TranspositionCacheEntry& b) { return a.depth > b.depth; });
+        entries.resize(maxEntries);
+
+        std::sort(entries.begin(), entries.end(),
+            [](const TranspositionCacheEntry& a, const TranspositionCacheEntry& b) { return a.key < b.key; });
+    }
+
+    TranspositionCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "C4TT", 4);
+    header.version = TRANSPOSITION_CACHE_VERSION;
+    header.entryCount = (uint32_t)entries.size();
+    header.evaluation = (uint8_t)evaluation;
+    header.rows = ConnectFourBoard::ROWS;
+    header.columns = ConnectFourBoard::COLUMNS;
+    header.checksum = Checksum(entries.data(), entries.size());
+
+    // A game closed halfway through the write keeps the old file
+    std::string temporary = std::string(path) + ".tmp";
+    if (!WriteMapped(temporary.c_str(), header, entries) || !ReplaceFile(temporary.c_str(), path))
+    {
+        remove(temporary.c_str());
+        return false;
+    }
+
+    entryCount = entries.size();
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef TRANSPOSITION_CACHE_H
+#define TRANSPOSITION_CACHE_H
+
+#include "ConnectFour.h"
+#include "TranspositionTable.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Keeps the deep entries of the transposition table between runs of the game. The game saves the
+// table on exit and loads it back on startup, every save adds to what the file already had so the
+// cache gets better the more games are played.
+//
+// File layout
+//
+// [header][entry][entry]...[entry]
+//
+// The entries are sorted by key. The checksum covers all entries, a file that was cut short or
+// changed in any way isn't loaded.
+struct TranspositionCacheHeader
+{
+    char magic[4];          // "C4TT"
+    uint32_t version;
+    uint32_t entryCount;
+    uint8_t evaluation;     // The scores are only good for the evaluation they were searched with
+    uint8_t rows;
+    uint8_t columns;
+    uint8_t reserved;
+    uint64_t checksum;      // FNV-1a of the entries
+};
+
+struct TranspositionCacheEntry
+{
+    uint64_t key;           // The table key, the player to move is part of it
+    int32_t score;
+    uint8_t depth;
+    Bound bound;
+    int8_t bestMove;
+    uint8_t padding;
+};
+
+static_assert(sizeof(TranspositionCacheHeader) == 24, "The cache header is part of the file format");
+static_assert(sizeof(TranspositionCacheEntry) == 16, "The cache entry is part of the file format");
+
+const static uint32_t TRANSPOSITION_CACHE_VERSION = 1;
+
+// Stores the entries of the file in the table and returns how many there were. 0 when the file is
+// missing, of another version, board or evaluation, or damaged. Not safe while a search is using the table.
+size_t LoadTranspositionCache(const char* path, Evaluation evaluation, TranspositionTable& table);
+
+// Writes the entries of the table searched at least minDepth deep to the file, together with the entries
+// the file already had. The deeper one wins when both have the same position, past maxEntries the
+// shallowest are left out. The file is written next to the old one and only replaces it when complete.
+// False when it can't be written. Not safe while a search is using the table.
+bool SaveTranspositionCache(const char* path, Evaluation evaluation, const TranspositionTable& table,
+    int minDepth, size_t maxEntries, size_t& entryCount);
+
+#endif
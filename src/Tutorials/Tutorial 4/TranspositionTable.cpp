@@ -0,0 +1,222 @@
+#include "TranspositionTable.h"
+
+namespace
+{
+    // Searches between two AgeEntries, half of what fits in the 8 bit generation leaves room for the entries it ages
+    const uint8_t GENERATION_AGE_INTERVAL = 64;
+}
+
+void TranspositionStatistics::Add(const TranspositionStatistics& other)
+{
+    probes      += other.probes;
+    hits        += other.hits;
+    collisions  += other.collisions;
+    stores      += other.stores;
+    overwrites  += other.overwrites;
+    rejected    += other.rejected;
+}
+
+float TranspositionStatistics::GetHitRate() const
+{
+    return probes > 0 ? hits / (float)probes : 0.0f;
+}
+
+float TranspositionStatistics::GetCollisionRate() const
+{
+    return probes > 0 ? collisions / (float)probes : 0.0f;
+}
+
+TranspositionTable::TranspositionTable()
+{
+    Resize(1);
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+{
+    Resize(megabytes);
+}
+
+void TranspositionTable::Resize(size_t megabytes)
+{
+    size_t budget = megabytes * 1024 * 1024;
+
+    // Power of two amount of entries so the index is a mask, but never more than the budget
+    size_t count = 1;
+    while (count * 2 * sizeof(Slot) <= budget) count *= 2;
+
+    slots.reset(new Slot[count]);
+    slotCount = count;
+    indexMask = count - 1;
+
+    Clear();
+}
+
+void TranspositionTable::Clear()
+{
+    for (size_t i = 0; i < slotCount; i++)
+    {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+
+    generation = 0;
+}
+
+void TranspositionTable::NewSearch()
+{
+    generation++;
+
+    // The generation is 8 bits, an entry from 256 searches ago would look like it's from this one and be kept
+    // over deeper results. Every 64 searches the older entries are made 64 searches old, so none of them gets
+    // older than 127 and all of them stay stale.
+    if (generation % GENERATION_AGE_INTERVAL == 0) AgeEntries(GENERATION_AGE_INTERVAL);
+}
+
+void TranspositionTable::AgeEntries(uint8_t maxAge)
+{
+    uint8_t oldest = (uint8_t)(generation - maxAge);
+
+    for (size_t i = 0; i < slotCount; i++)
+    {
+        uint64_t data = slots[i].data.load(std::memory_order_relaxed);
+        if (data == 0) continue;
+
+        TranspositionEntry entry = Unpack(data);
+        if ((uint8_t)(generation - entry.generation) <= maxAge) continue;
+
+        uint64_t key = slots[i].check.load(std::memory_order_relaxed) ^ data;
+        entry.generation = oldest;
+
+        data = Pack(entry);
+        slots[i].data.store(data, std::memory_order_relaxed);
+        slots[i].check.store(key ^ data, std::memory_order_relaxed);
+    }
+}
+
+bool TranspositionTable::Probe(uint64_t key, TranspositionEntry& entry, TranspositionStatistics& statistics) const
+{
+    const Slot& slot = slots[GetIndex(key)];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+    statistics.probes++;
+
+    if (data == 0) return false;
+
+    if ((check ^ data) != key)
+    {
+        statistics.collisions++;
+        return false;
+    }
+
+    statistics.hits++;
+    entry = Unpack(data);
+    return true;
+}
+
+void TranspositionTable::Store(uint64_t key, int depth, int score, Bound bound, int bestMove, TranspositionStatistics& statistics)
+{
+    Slot& slot = slots[GetIndex(key)];
+    uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+    uint64_t oldCheck = slot.check.load(std::memory_order_relaxed);
+    TranspositionEntry old = Unpack(oldData);
+
+    bool samePosition = oldData != 0 && (oldCheck ^ oldData) == key;
+    bool stale = oldData == 0 || old.generation != generation;
+
+    // Depth-preferred, a shallow result doesn't push out a deeper one from this search
+    if (!samePosition && !stale && depth < old.depth)
+    {
+        statistics.rejected++;
+        return;
+    }
+
+    if (!samePosition && oldData != 0) statistics.overwrites++;
+    statistics.stores++;
+
+    // Keep the old move when this search didn't find one
+    if (bestMove < 0 && samePosition) bestMove = old.bestMove;
+
+    TranspositionEntry entry;
+    entry.score = score;
+    entry.depth = (uint8_t)depth;
+    entry.bound = bound;
+    entry.bestMove = (int8_t)bestMove;
+    entry.generation = generation;
+
+    uint64_t data = Pack(entry);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+bool TranspositionTable::ReadSlot(size_t index, uint64_t& key, TranspositionEntry& entry) const
+{
+    const Slot& slot = slots[index];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+    if (data == 0) return false;
+
+    key = check ^ data;
+    entry = Unpack(data);
+    return entry.bound != Bound::NONE;
+}
+
+size_t TranspositionTable::GetEntryCount() const
+{
+    return slotCount;
+}
+
+size_t TranspositionTable::GetSizeInBytes() const
+{
+    return slotCount * sizeof(Slot);
+}
+
+float TranspositionTable::GetUsage() const
+{
+    // Looking at the first thousand slots is close enough, the index spreads positions evenly
+    size_t sample = slotCount < 1000 ? slotCount : 1000;
+    size_t used = 0;
+
+    for (size_t i = 0; i < sample; i++)
+    {
+        uint64_t data = slots[i].data.load(std::memory_order_relaxed);
+        if (data != 0 && Unpack(data).generation == generation) used++;
+    }
+
+    return used / (float)sample;
+}
+
+// 64 bits of entry
+// [generation 8][best move + 1 8][bound 8][depth 8][score 32]
+uint64_t TranspositionTable::Pack(const TranspositionEntry& entry)
+{
+    return (uint64_t)(uint32_t)entry.score |
+        ((uint64_t)entry.depth << 32) |
+        ((uint64_t)entry.bound << 40) |
+        ((uint64_t)(uint8_t)(entry.bestMove + 1) << 48) |
+        ((uint64_t)entry.generation << 56);
+}
+
+TranspositionEntry TranspositionTable::Unpack(uint64_t data)
+{
+    TranspositionEntry entry;
+    entry.score = (int32_t)(uint32_t)data;
+    entry.depth = (uint8_t)(data >> 32);
+    entry.bound = (Bound)(uint8_t)(data >> 40);
+    entry.bestMove = (int8_t)((uint8_t)(data >> 48) - 1);
+    entry.generation = (uint8_t)(data >> 56);
+    return entry;
+}
+
+size_t TranspositionTable::GetIndex(uint64_t key) const
+{
+    // Positions that differ in a single column differ in few bits, mix them before masking (splitmix64)
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+
+    return (size_t)(key & indexMask);
+}
@@ -0,0 +1,101 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+enum class Bound : uint8_t
+{
+    NONE    = 0,
+    EXACT   = 1,    // The score is the real score
+    LOWER   = 2,    // The real score is at least the score (the search failed high)
+    UPPER   = 3,    // The real score is at most the score (the search failed low)
+};
+
+struct TranspositionEntry
+{
+    int32_t score       = 0;
+    uint8_t depth       = 0;
+    Bound bound         = Bound::NONE;
+    int8_t bestMove     = -1;
+    uint8_t generation  = 0;
+};
+
+// Counted by every search on its own, so threads sharing a table don't fight over the counters
+struct TranspositionStatistics
+{
+    long long probes        = 0;    // Lookups
+    long long hits          = 0;    // Lookups that found the position
+    long long collisions    = 0;    // Lookups that found another position in the slot
+    long long stores        = 0;    // Entries written
+    long long overwrites    = 0;    // Entries written over another position
+    long long rejected      = 0;    // Entries not written because the slot holds a deeper search
+
+    void Add(const TranspositionStatistics& other);
+
+    float GetHitRate() const;
+    float GetCollisionRate() const;
+};
+
+// A fixed size hash table of search results. Every position has exactly one slot, a new result only
+// replaces another position's result when it was searched at least as deep or the old one is from an
+// earlier search.
+//
+// Any amount of threads can probe and store at the same time. A slot is two words, the entry and the
+// entry xor'ed with the key. A slot half written by another thread doesn't match its key and reads as
+// a different position.
+class TranspositionTable
+{
+public:
+    TranspositionTable();
+    explicit TranspositionTable(size_t megabytes);
+
+    // Throws away all entries and sizes the table to fit in the memory budget.
+    // Not safe while a search is using the table.
+    void Resize(size_t megabytes);
+    void Clear();
+
+    // Call before every search, older entries become the first to be replaced. Not safe while a search
+    // is using the table, every now and then it walks all entries (see AgeEntries).
+    void NewSearch();
+
+    // Returns true and fills the entry when the position is in the table
+    bool Probe(uint64_t key, TranspositionEntry& entry, TranspositionStatistics& statistics) const;
+    void Store(uint64_t key, int depth, int score, Bound bound, int bestMove, TranspositionStatistics& statistics);
+
+    // Fills the key and entry of the slot, false when it is empty. For walking the whole table, index
+    // goes up to GetEntryCount. Not safe while a search is storing, a half written slot reads as
+    // some other position.
+    bool ReadSlot(size_t index, uint64_t& key, TranspositionEntry& entry) const;
+
+    size_t GetEntryCount() const;
+    size_t GetSizeInBytes() const;
+
+    // Estimated amount of slots used by the current search, 0 to 1
+    float GetUsage() const;
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> check;    // key ^ data
+        std::atomic<uint64_t> data;     // The packed entry, 0 when empty
+    };
+
+    static uint64_t Pack(const TranspositionEntry& entry);
+    static TranspositionEntry Unpack(uint64_t data);
+
+    size_t GetIndex(uint64_t key) const;
+
+    // Makes every entry more than maxAge searches old exactly maxAge old
+    void AgeEntries(uint8_t maxAge);
+
+private:
+    std::unique_ptr<Slot[]> slots;
+    size_t slotCount        = 0;
+    uint64_t indexMask      = 0;
+    uint8_t generation      = 0;
+};
+
+#endif
@@ -13,9 +13,18 @@
 #include <string>   // Used for 'to_string'
 
 #include <chrono>
+#include <mutex>
+#include <thread>
 
 #include "Shaders.h"
+#include "AIWorker.h"
 #include "ConnectFour.h"
+#include "ConnectFourView.h"
+#include "ConnectFourAI.h"
+#include "ConnectFourMCTS.h"
+#include "ConnectFourSolver.h"
+#include "OpeningBook.h"
+#include "TranspositionCache.h"
 
 /*---------------------------- Variables ----------------------------*/
 // GLFW window
@@ -43,32 +52,184 @@ glm::mat4 projectionMatrix;
 
 // Connect 4 board
 ConnectFourBoard mainGameBoard;
+ConnectFourView boardView;
 bool gameOver = false;
 float animationTimer = -10.0f;
 
-// Functions
-typedef glm::ivec2 ColumnScore;
-const int NIL = -1; // Because NULL is 0 and we use 0
-
+// AI
 std::vector<float> times;
 int AILevel = 7;
-float aiScoreTotal = 0;
-int aiScoreCount = 0;
-float playerScoreTotal = 0;
-int playerScoreCount = 0;
+int alphaBetaLevel = 12;
+SearchAlgorithm searchAlgorithm = SearchAlgorithm::ALPHA_BETA;
+bool compareWithMinimax = false;
+long long lastSearchNodes = 0;
+int lastSearchDepth = 0;
+
+// What the last alpha-beta search counted, per depth too. With writeSearchLog every decision is
+// appended to the log as one JSON line, to graph how the engine does over many games.
+SearchStatistics lastSearchStatistics;
+bool writeSearchLog = false;
+const char* searchLogFile = "SearchLog.jsonl";
+int gameNumber = 1;
+
+// Alpha-beta deepens the search until the budget (in milliseconds) is spent instead of using a fixed depth
+bool useTimeBudget = true;
+float aiTimeBudget = 500.0f;
+
+// Remembers positions between searches, sized by the memory budget in megabytes
+int transpositionTableMegabytes = 64;
+TranspositionTable transpositionTable;
+
+// The deep entries of the table are saved on exit and loaded on startup, the AI starts every session
+// knowing what the earlier ones searched. Only entries searched at least tableCacheDepth deep are kept.
+bool useTableCache = true;
+const char* tableCacheFile = "TranspositionCache.bin";
+int tableCacheDepth = 8;
+size_t tableCacheMaxEntries = 1 << 20;
+size_t tableCacheLoaded = 0;
+
+// Mirror images share their table entries, the table holds twice the positions. Off by default like
+// SearchContext::useMirrorSymmetry, with it the comparison with minimax can disagree after a won game.
+bool useMirrorSymmetry = false;
+
+// The window alpha-beta searches the root in, every one plays the same moves. The narrow ones save nodes on
+// one thread, split over more threads they hardly do.
+SearchWindow searchWindow = SearchWindow::FULL;
+
+// Alpha-beta scores the boards by pattern instead of counting the AI coins, it plays better at the same depth.
+// The table is cleared when this changes, only the AI threads touch tableEvaluation.
+bool usePatternEvaluation = true;
+Evaluation tableEvaluation = Evaluation::WINDOW_COUNT;
+
+// Threads the alpha-beta search splits the root moves over
+int aiThreadCount = 1;
+
+// Monte Carlo plays out this many games per move when it has no time budget
+int monteCarloIterations = 200000;
+float lastMonteCarloWinRate = 0.0f;
+
+// Moves of the first plies are looked up instead of searched, when the book file is there
+bool useOpeningBook = true;
+OpeningBook openingBook;
+
+// With this few empty cells left alpha-beta hands over to the solver, which plays perfectly
+bool useEndgameSolver = true;
+int solverEmptyCells = 20;
+
+// The solver is only quick close to the end, a few more empty cells make it a lot slower
+const int MAX_SOLVER_EMPTY_CELLS = 26;
+TranspositionTable solverTable;
+SolverResult lastSolverResult;
+bool lastMoveSolved = false;
+
+// Everything GenerateComputerDecision needs, copied when the AI starts thinking
+struct AISettings
+{
+    SearchAlgorithm algorithm;
+    int minimaxLevel;
+    int alphaBetaLevel;
+    bool useTimeBudget;
+    float timeBudget;
+    int threadCount;
+    int monteCarloIterations;
+    bool useOpeningBook;
+    bool useEndgameSolver;
+    int solverEmptyCells;
+    bool compareWithMinimax;
+    bool useMirrorSymmetry;
+    Evaluation evaluation;
+    SearchWindow window;
+};
+
+// The move and everything the GUI shows about how it was found
+struct AIDecision
+{
+    int column = NIL;
+    float time = 0.0f;
+    long long nodes = 0;
+    int depth = 0;
+    const char* method = "";    // Book, solver or the name of the search
+    SearchStatistics statistics;
+    bool solved = false;
+    SolverResult solverResult;
+    float monteCarloWinRate = 0.0f;
+    int minimaxLevel = 7;
+};
+
+// The AI thinks on its own thread, the window keeps drawing in the meantime
+AIWorker<AIDecision> aiWorker;
+
+bool SameSettings(const AISettings& a, const AISettings& b)
+{
+    return a.algorithm == b.algorithm && a.minimaxLevel == b.minimaxLevel && a.alphaBetaLevel == b.alphaBetaLevel &&
+        a.useTimeBudget == b.useTimeBudget && a.timeBudget == b.timeBudget && a.threadCount == b.threadCount &&
+        a.monteCarloIterations == b.monteCarloIterations && a.useOpeningBook == b.useOpeningBook &&
+        a.useEndgameSolver == b.useEndgameSolver && a.solverEmptyCells == b.solverEmptyCells &&
+        a.compareWithMinimax == b.compareWithMinimax && a.useMirrorSymmetry == b.useMirrorSymmetry &&
+        a.evaluation == b.evaluation && a.window == b.window;
+}
+
+// Decisions worked out on the human's time, one for every reply the human can make
+struct PonderCache
+{
+    std::mutex mutex;
+    AISettings settings;
+    bool ready[ConnectFourBoard::COLUMNS];
+    uint64_t keys[ConnectFourBoard::COLUMNS];
+    AIDecision decisions[ConnectFourBoard::COLUMNS];
+
+    void Clear(const AISettings& newSettings)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        settings = newSettings;
+        for (int i = 0; i < ConnectFourBoard::COLUMNS; i++) ready[i] = false;
+    }
+
+    void Store(int reply, uint64_t key, const AIDecision& decision)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready[reply] = true;
+        keys[reply] = key;
+        decisions[reply] = decision;
+    }
+
+    // Only a decision for the same board made with the same settings counts
+    bool Take(uint64_t key, const AISettings& currentSettings, AIDecision& decision)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!SameSettings(settings, currentSettings)) return false;
 
-ColumnScore MaximizePlay(ConnectFourBoard& board, int depth);
-ColumnScore MinimizePlay(ConnectFourBoard& board, int depth);
+        for (int i = 0; i < ConnectFourBoard::COLUMNS; i++)
+        {
+            if (ready[i] && keys[i] == key)
+            {
+                decision = decisions[i];
+                ready[i] = false;
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+// While the human thinks the AI works out its answers to the likely replies, the most likely one first
+bool usePondering = true;
+AIWorker<int> ponderWorker;
+PonderCache ponderCache;
+int ponderHits = 0;
+int ponderMisses = 0;
 
 
 void DrawQuad(glm::vec2, glm::vec2);
 bool GetMouseClicked();
+bool GetRestartPressed();
 
 std::chrono::high_resolution_clock::time_point timerStart;
 
 void RestartTimer()
 {
-	std::chrono::high_resolution_clock::time_point timerStart = std::chrono::high_resolution_clock::now();
+	timerStart = std::chrono::high_resolution_clock::now();
 }
 
 float StopTimer()
@@ -113,94 +274,308 @@ void Initialize()
 
     glActiveTexture(GL_TEXTURE0);
 
-    mainGameBoard.InitializeBoard();
+    mainGameBoard.ResetBoard();
+    boardView.Initialize();
+
+    transpositionTable.Resize(transpositionTableMegabytes);
+    solverTable.Resize(16);
+
+    // The empty table is good for either evaluation, the cache only has entries for the one in use
+    tableEvaluation = usePatternEvaluation ? Evaluation::PATTERNS : Evaluation::WINDOW_COUNT;
+    if (useTableCache)
+    {
+        tableCacheLoaded = LoadTranspositionCache(tableCacheFile, tableEvaluation, transpositionTable);
+        if (tableCacheLoaded > 0) printf("Table cache: %i positions\n", (int)tableCacheLoaded);
+    }
+
+    if (openingBook.Open(ASSETS"OpeningBook.bin"))
+        printf("Opening book: %u positions up to ply %u, %s\n", openingBook.GetEntryCount(), openingBook.GetMaxPly(),
+            openingBook.GetEvaluation() == Evaluation::PATTERNS ? "patterns" : "window count");
+
+    aiThreadCount = std::max(1, (int)std::thread::hardware_concurrency());
 }
 
-ColumnScore MaximizePlay(ConnectFourBoard& board, int depth)
+// The settings a decision uses, copied when it starts so the GUI can change them in the meantime
+AISettings GetAISettings()
 {
-    // Call score of our board
-    int score = board.SimpleScoring();
-	aiScoreTotal += score;
-	aiScoreCount++;
+    AISettings settings;
+    settings.algorithm = searchAlgorithm;
+    settings.minimaxLevel = AILevel;
+    settings.alphaBetaLevel = alphaBetaLevel;
+    settings.useTimeBudget = useTimeBudget;
+    settings.timeBudget = aiTimeBudget;
+    settings.threadCount = aiThreadCount;
+    settings.monteCarloIterations = monteCarloIterations;
+    settings.useOpeningBook = useOpeningBook;
+    settings.useEndgameSolver = useEndgameSolver;
+    settings.solverEmptyCells = std::min(solverEmptyCells, MAX_SOLVER_EMPTY_CELLS);
+    settings.compareWithMinimax = compareWithMinimax;
+    settings.useMirrorSymmetry = useMirrorSymmetry;
+    settings.evaluation = usePatternEvaluation ? Evaluation::PATTERNS : Evaluation::WINDOW_COUNT;
+    settings.window = searchWindow;
+    return settings;
+}
 
-    // Break
-    if (board.IsFinished() || depth == 0) return ColumnScore(NIL, score);
+// Runs on the AI worker, everything it changes goes back through the decision
+AIDecision GenerateComputerDecision(ConnectFourBoard tempBoard, AISettings settings, const std::atomic<bool>& cancelled)
+{
+    AIDecision decision;
+    decision.minimaxLevel = settings.minimaxLevel;
 
-    // Column, Score
-    ColumnScore max = ColumnScore(NIL, -99999);
+	RestartTimer();
 
-    // For all possible moves
-    for (int column = 0; column < board.COLUMNS; column++)
+    // The scores in the table were searched with the other evaluation, they'd only mislead the search
+    if (settings.evaluation != tableEvaluation)
     {
-        ConnectFourBoard newBoard = board.CreateCopy(); // Create new board
+        transpositionTable.Clear();
+        tableEvaluation = settings.evaluation;
+    }
 
-        if (newBoard.DropCoin(column, Player::AI))
-        {
-            ColumnScore nextMove = MinimizePlay(newBoard, depth - 1); // Recursive calling
+    transpositionTable.NewSearch();
 
-            // Evaluate new move
-            if (max[0] == NIL || nextMove[1] > max[1])
-            {
-                max[0] = column;
-                max[1] = nextMove[1];
-            }
+    SearchContext context;
+    context.transpositionTable = &transpositionTable;
+    context.threadCount = settings.threadCount;
+    context.useMirrorSymmetry = settings.useMirrorSymmetry;
+    context.evaluation = settings.evaluation;
+    context.window = settings.window;
+    context.cancelled = &cancelled;
+
+    int depth = settings.algorithm == SearchAlgorithm::MINIMAX ? settings.minimaxLevel : settings.alphaBetaLevel;
+    ColumnScore aiMove;
+
+    // A book searched with the other evaluation would play the first moves of another engine
+    ColumnScore bookMove;
+    if (settings.useOpeningBook && openingBook.GetEvaluation() == settings.evaluation &&
+        openingBook.Lookup(tempBoard, Player::AI, bookMove))
+    {
+        decision.column = bookMove[0];
+        decision.depth = openingBook.GetDepth();
+        decision.method = "Opening book";
+
+        printf("Opening book: column %i, score %i\n", bookMove[0], bookMove[1]);
+
+        decision.time = StopTimer();
+        return decision;
+    }
+
+    int emptyCells = tempBoard.ROWS * tempBoard.COLUMNS - tempBoard.GetNumberOfMoves();
+    decision.solved = settings.algorithm == SearchAlgorithm::ALPHA_BETA && settings.useEndgameSolver &&
+        emptyCells <= settings.solverEmptyCells;
+
+    float searchBudget = settings.timeBudget;
+    SolverContext solverContext;
+
+    if (decision.solved)
+    {
+        // Every solve has fewer empty cells than the one before, the older and deeper entries mustn't block its stores
+        solverTable.NewSearch();
+
+        solverContext.transpositionTable = &solverTable;
+        solverContext.cancelled = &cancelled;
+
+        // Half the time budget, the search gets the other half when the solver doesn't make it
+        if (settings.useTimeBudget)
+        {
+            searchBudget = settings.timeBudget / 2.0f;
+            solverContext.useDeadline = true;
+            solverContext.deadline = std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(searchBudget));
         }
+
+        decision.solverResult = SolvePosition(tempBoard, Player::AI, solverContext);
+
+        // Nobody is waiting for the move anymore
+        if (cancelled) return decision;
     }
 
-    return max;
-}
+    if (decision.solved && solverContext.aborted)
+    {
+        printf("Solver: out of time after %lld nodes, searching instead\n", solverContext.nodes);
+        decision.solved = false;
+    }
+    else if (decision.solved)
+    {
+        decision.column = decision.solverResult.column;
+        decision.nodes = solverContext.nodes;
+        decision.depth = emptyCells;
+        decision.method = "Solver";
 
-ColumnScore MinimizePlay(ConnectFourBoard& board, int depth)
-{
-    int score = board.SimpleScoring();
-	playerScoreTotal += score;
-	playerScoreCount++;
+        const char* outcomes[] = { "loses", "draws", "wins" };
+        printf("Solver: column %i, AI %s in %i moves, %lld nodes\n", decision.solverResult.column,
+            outcomes[decision.solverResult.value + 1], decision.solverResult.distance, solverContext.nodes);
+
+        decision.time = StopTimer();
+        return decision;
+    }
+
+    if (settings.algorithm == SearchAlgorithm::MONTE_CARLO)
+    {
+        MonteCarloSettings monteCarloSettings;
+        monteCarloSettings.iterations = settings.useTimeBudget ? 0 : settings.monteCarloIterations;
+        monteCarloSettings.timeBudget = settings.useTimeBudget ? settings.timeBudget : 0.0f;
+        monteCarloSettings.threadCount = settings.threadCount;
+        monteCarloSettings.cancelled = &cancelled;
 
-    if (board.IsFinished() || depth == 0) return ColumnScore(NIL, score);
+        MonteCarloResult result = MonteCarloPlay(tempBoard, Player::AI, monteCarloSettings);
 
-    ColumnScore min = ColumnScore(NIL, 99999);
+        decision.column = result.column;
+        decision.nodes = result.iterations;
+        decision.method = GetSearchAlgorithmName(settings.algorithm);
+        decision.monteCarloWinRate = result.winRate;
 
-    for (int column = 0; column < board.COLUMNS; column++)
+        printf("%s: column %i, %.1f%% wins, %lld playouts, %i nodes\n", GetSearchAlgorithmName(settings.algorithm),
+            result.column, result.winRate * 100.0f, result.iterations, result.nodes);
+
+        decision.time = StopTimer();
+        return decision;
+    }
+
+    if (settings.algorithm == SearchAlgorithm::ALPHA_BETA && settings.useTimeBudget)
     {
-        ConnectFourBoard newBoard = board.CreateCopy();
+        aiMove = IterativeDeepeningPlay(tempBoard, Player::AI, tempBoard.ROWS * tempBoard.COLUMNS, searchBudget, context);
+        depth = context.statistics.depth;
+    }
+    else
+    {
+        aiMove = SearchPlay(settings.algorithm, tempBoard, depth, context);
+    }
 
-        if (newBoard.DropCoin(column, Player::HUMAN))
-        {
-            ColumnScore nextMove = MaximizePlay(newBoard, depth - 1);
+    // Nobody is waiting for the move anymore
+    if (cancelled) return decision;
 
-            if (min[0] == NIL || nextMove[1] < min[1])
-            {
-                min[0] = column;
-                min[1] = nextMove[1];
-            }
-        }
+    const SearchStatistics& statistics = context.statistics;
+    decision.column = aiMove[0];
+    decision.nodes = statistics.nodes;
+    decision.depth = depth;
+    decision.method = GetSearchAlgorithmName(settings.algorithm);
+    decision.statistics = statistics;
+
+    printf("%s depth %i: column %i, score %i, %lld nodes\n", GetSearchAlgorithmName(settings.algorithm),
+        depth, aiMove[0], aiMove[1], statistics.nodes);
+
+    if (settings.algorithm == SearchAlgorithm::ALPHA_BETA)
+    {
+        const TranspositionStatistics& tableStatistics = statistics.table;
+        printf("Transposition table: %lld probes, %.1f%% hits, %.1f%% collisions, %.1f%% used\n",
+            tableStatistics.probes, tableStatistics.GetHitRate() * 100.0f,
+            tableStatistics.GetCollisionRate() * 100.0f, transpositionTable.GetUsage() * 100.0f);
+        printf("Cutoffs: %lld, %.1f%% by the first move\n", statistics.cutoffs, statistics.GetFirstMoveCutoffRate() * 100.0f);
     }
-    return min;
+
+    if (settings.algorithm == SearchAlgorithm::MINIMAX)
+    {
+        printf("AI:%f\nP1:%f\n", statistics.aiScoreTotal / statistics.aiScoreCount,
+            statistics.playerScoreTotal / statistics.playerScoreCount);
+        printf("AI:%f, %i\nP1:%f, %i\n", statistics.aiScoreTotal, statistics.aiScoreCount,
+            statistics.playerScoreTotal, statistics.playerScoreCount);
+        if (statistics.aiScoreTotal / statistics.aiScoreCount < statistics.playerScoreTotal / statistics.playerScoreCount)
+            decision.minimaxLevel = 7;
+        else
+            decision.minimaxLevel = 5;
+    }
+    else if (settings.compareWithMinimax && !settings.useTimeBudget && settings.evaluation == Evaluation::WINDOW_COUNT)
+    {
+        // Same depth through the old search, both have to agree on the move. Minimax only counts coins.
+        SearchStatistics minimaxStatistics;
+        ConnectFourBoard minimaxBoard = tempBoard.CreateCopy();
+        ColumnScore minimaxMove = MaximizePlay(minimaxBoard, depth, minimaxStatistics, &cancelled);
+        if (cancelled) return decision;
+
+        printf("Minimax depth %i: column %i, score %i, %lld nodes (%s)\n", depth, minimaxMove[0], minimaxMove[1],
+            minimaxStatistics.nodes, minimaxMove == aiMove ? "same" : "DIFFERENT");
+    }
+
+	decision.time = StopTimer();
+
+    return decision;
 }
 
-int GenerateComputerDecision()
+// One line per decision, the board is still the one the AI decided on
+void WriteSearchLog(const AIDecision& decision)
 {
-	RestartTimer();
+    FILE* file = fopen(searchLogFile, "a");
+    if (!file) return;
+
+    fprintf(file, "{\"game\":%i,\"ply\":%i,\"method\":\"%s\",\"column\":%i,\"ms\":%.3f,\"nodes\":%lld,\"depth\":%i,\"search\":%s}\n",
+        gameNumber, mainGameBoard.GetNumberOfMoves(), decision.method, decision.column, decision.time, decision.nodes,
+        decision.depth, decision.statistics.ToJson().c_str());
+
+    fclose(file);
+}
+
+// Back on the render thread, the results of a finished decision go where the GUI shows them
+void ApplyAIDecision(const AIDecision& decision)
+{
+    times.push_back(decision.time);
+    lastSearchNodes = decision.nodes;
+    lastSearchDepth = decision.depth;
+    lastSearchStatistics = decision.statistics;
+    lastMoveSolved = decision.solved;
+    lastSolverResult = decision.solverResult;
+    lastMonteCarloWinRate = decision.monteCarloWinRate;
+    AILevel = decision.minimaxLevel;
+
+    if (writeSearchLog) WriteSearchLog(decision);
+}
+
+// Starts searching the position after every reply of the human, the move the search expects first.
+// Every finished reply goes into the ponder cache, the rest is thrown away when the human moves.
+void StartPondering()
+{
+    ConnectFourBoard board = mainGameBoard.CreateCopy();
+    AISettings settings = GetAISettings();
+
+    ponderCache.Clear(settings);
+
+    ponderWorker.Start([board, settings](const std::atomic<bool>& cancelled)
+    {
+        ConnectFourBoard position = board;
+
+        int order[ConnectFourBoard::COLUMNS] = { 3, 2, 4, 1, 5, 0, 6 };
+        int expected = GetTableMove(position, Player::HUMAN, transpositionTable);
 
-    ConnectFourBoard tempBoard = mainGameBoard.CreateCopy();
+        // The expected reply to the front, the others stay center first
+        for (int i = 0; expected != NIL && i < ConnectFourBoard::COLUMNS && order[0] != expected; i++)
+        {
+            if (order[i] != expected) continue;
+            for (; i > 0; i--) order[i] = order[i - 1];
+            order[0] = expected;
+        }
+
+        int pondered = 0;
+        for (int i = 0; i < ConnectFourBoard::COLUMNS && !cancelled; i++)
+        {
+            ConnectFourBoard reply = position;
+            if (!reply.DropCoin(order[i], Player::HUMAN)) continue;
+
+            // Nothing to answer when the human wins or fills the board
+            if (ConnectFourBoard::FourInARow(reply.GetCoins(Player::HUMAN)) || reply.IsFinished()) continue;
 
-    ColumnScore aiMove = MaximizePlay(tempBoard, AILevel);
-	
-	printf("AI:%f\nP1:%f\n", aiScoreTotal / aiScoreCount, playerScoreTotal / playerScoreCount);
-	printf("AI:%f, %i\nP1:%f, %i\n", aiScoreTotal, aiScoreCount, playerScoreTotal, playerScoreCount);
-	if (aiScoreTotal / aiScoreCount < playerScoreTotal / playerScoreCount)
-		AILevel = 7;
-	else
-		AILevel = 5;
+            reply.SetPlayerTurn(Player::AI);
 
-	aiScoreTotal = 0;
-	aiScoreCount = 0;
-	playerScoreTotal = 0;
-	playerScoreCount = 0;
+            AIDecision decision = GenerateComputerDecision(reply, settings, cancelled);
+            if (cancelled) break;
 
-	times.push_back(StopTimer());
+            ponderCache.Store(order[i], reply.GetPositionKey(), decision);
+            pondered++;
+        }
 
-    return aiMove[0];
+        return pondered;
+    });
+}
+
+// Starts a new game, the solver's entries are of positions the new game won't get to
+void RestartGame()
+{
+    // The AI's move is for the old board
+    aiWorker.Cancel();
+    ponderWorker.Cancel();
+
+    gameOver = false;
+    mainGameBoard.ResetBoard();
+    solverTable.Clear();
+    gameNumber++;
 }
 
 void Update(float a_deltaTime)
@@ -208,8 +583,41 @@ void Update(float a_deltaTime)
     if (glfwGetKey(window, GLFW_KEY_ESCAPE))
         glfwSetWindowShouldClose(window, true);
 
-    if (glfwGetKey(window, GLFW_KEY_R))
-        mainGameBoard.ResetBoard();
+    if (GetRestartPressed()) RestartGame();
+
+#ifndef RANDOM_AI
+    // The AI starts thinking while the human's coin is still falling
+    if (mainGameBoard.GetPlayerTurn() == Player::AI && !gameOver && !mainGameBoard.IsFinished() && !aiWorker.IsBusy())
+    {
+        ConnectFourBoard board = mainGameBoard.CreateCopy();
+        AISettings settings = GetAISettings();
+
+        // Pondering shares the transposition table, it has to stop before the real search starts
+        bool pondering = ponderWorker.IsBusy();
+        ponderWorker.Cancel();
+
+        AIDecision pondered;
+        if (ponderCache.Take(board.GetPositionKey(), settings, pondered))
+        {
+            // Worked out on the human's time already
+            ponderHits++;
+            pondered.time = 0.0f;
+
+            aiWorker.Start([pondered](const std::atomic<bool>&) { return pondered; });
+        }
+        else
+        {
+            // The human played something else or was faster than the pondering,
+            // the search at least finds the table filled
+            if (pondering) ponderMisses++;
+
+            aiWorker.Start([board, settings](const std::atomic<bool>& cancelled)
+            {
+                return GenerateComputerDecision(board, settings, cancelled);
+            });
+        }
+    }
+#endif
 
     // Don't make moves while things are animating
     if (glfwGetTime() - animationTimer < 1.0f) return;
@@ -217,11 +625,7 @@ void Update(float a_deltaTime)
     // Simple function to get if the mouse was clicked
     bool leftMouseWasClicked = GetMouseClicked();
 
-    if (leftMouseWasClicked && gameOver)
-    {
-        gameOver = false;
-        mainGameBoard.ResetBoard();
-    }
+    if (leftMouseWasClicked && gameOver) RestartGame();
 
     if (mainGameBoard.GetPlayerTurn() == Player::HUMAN) // Player Turn
     {
@@ -253,22 +657,30 @@ void Update(float a_deltaTime)
     {
         if (gameOver) return;   // Don't do AI if the game is over
 
-        do // Do the AI logic ...
-        {
 #ifdef RANDOM_AI
-            // Pick a random slot to drop the coin in
-            if (mainGameBoard.DropCoin(rand() % 7, Player::AI))
-            {
-                mainGameBoard.SetPlayerTurn(Player::HUMAN);
-            }
+        // Pick a random slot to drop the coin in
+        if (mainGameBoard.DropCoin(rand() % 7, Player::AI))
+        {
+            mainGameBoard.SetPlayerTurn(Player::HUMAN);
+        }
 #else
-            if (mainGameBoard.DropCoin(GenerateComputerDecision(), Player::AI))
-            {
-                mainGameBoard.SetPlayerTurn(Player::HUMAN);
-                animationTimer = glfwGetTime();
-            }
+        // Still thinking, try again next frame
+        AIDecision decision;
+        if (!aiWorker.Poll(decision)) return;
+
+        ApplyAIDecision(decision);
+
+        // A decision that can't be played is thought over again next frame
+        if (mainGameBoard.DropCoin(decision.column, Player::AI))
+        {
+            mainGameBoard.SetPlayerTurn(Player::HUMAN);
+            animationTimer = glfwGetTime();
+
+            bool aiWon = ConnectFourBoard::FourInARow(mainGameBoard.GetCoins(Player::AI));
+            if (usePondering && !aiWon && !mainGameBoard.IsFinished()) StartPondering();
+        }
 #endif
-        } while (mainGameBoard.GetPlayerTurn() != Player::HUMAN); // ... while it's not the humans turn
+        if (mainGameBoard.GetPlayerTurn() != Player::HUMAN) return;
 
         // Now check if the AI won
         if (mainGameBoard.SimpleScoring() == mainGameBoard.MAX_SCORE)
@@ -283,14 +695,15 @@ void Render()
 {
     glUseProgram(shaderProgram);
 
-    if      (mainGameBoard.SimpleScoring() ==  mainGameBoard.MAX_SCORE) glClearColor(0.3f, 0.0f, 0.0f, 1.0f);
-    else if (mainGameBoard.SimpleScoring() == -mainGameBoard.MAX_SCORE) glClearColor(0.0f, 0.3f, 0.0f, 1.0f);
+    int score = mainGameBoard.SimpleScoring();
+    if      (score ==  mainGameBoard.MAX_SCORE) glClearColor(0.3f, 0.0f, 0.0f, 1.0f);
+    else if (score == -mainGameBoard.MAX_SCORE) glClearColor(0.0f, 0.3f, 0.0f, 1.0f);
     else     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     
     viewMatrix = glm::mat4(1.0f);
-    projectionMatrix = glm::ortho(0.0f, (float)mainGameBoard.PIXEL_WIDTH, 0.0f, (float)mainGameBoard.PIXEL_HEIGHT, -1.0f, 1.0f);
+    projectionMatrix = glm::ortho(0.0f, (float)boardView.PIXEL_WIDTH, 0.0f, (float)boardView.PIXEL_HEIGHT, -1.0f, 1.0f);
 
-    mainGameBoard.DrawBoard(DrawQuad);
+    boardView.DrawBoard(mainGameBoard, DrawQuad);
 
     glUseProgram(GL_NONE);
 }
@@ -309,7 +722,117 @@ void GUI()
 			// And plot it using ImGui
 			ImGui::PlotHistogram("AI Decision Times", &times[0],
 				times.size(), 0, NULL, min, max, ImVec2(0, 80));
-			ImGui::Text("AIDepth: %i", AILevel);
+			ImGui::Text("AIDepth: %i", lastSearchDepth);
+			ImGui::Text("Nodes: %lld", lastSearchNodes);
+		}
+
+		// Per depth of the last alpha-beta search, the effective branching factor is the
+		// nodes of a depth per node of the depth before it
+		const std::vector<IterationStatistics>& iterations = lastSearchStatistics.iterations;
+		if (!iterations.empty() && ImGui::CollapsingHeader("Search statistics"))
+		{
+			ImGui::Text("Cutoffs: %lld, %.1f%% by the first move", lastSearchStatistics.cutoffs,
+				lastSearchStatistics.GetFirstMoveCutoffRate() * 100.0f);
+			ImGui::Text("Table: %lld probes, %.1f%% hits", lastSearchStatistics.table.probes,
+				lastSearchStatistics.table.GetHitRate() * 100.0f);
+
+			ImGui::Columns(6, "iterations");
+			ImGui::Text("Depth"); ImGui::NextColumn();
+			ImGui::Text("Nodes"); ImGui::NextColumn();
+			ImGui::Text("Cutoffs"); ImGui::NextColumn();
+			ImGui::Text("Hits"); ImGui::NextColumn();
+			ImGui::Text("EBF"); ImGui::NextColumn();
+			ImGui::Text("ms"); ImGui::NextColumn();
+			ImGui::Separator();
+
+			for (const IterationStatistics& iteration : iterations)
+			{
+				float hitRate = iteration.tableProbes > 0 ? (float)iteration.tableHits / iteration.tableProbes : 0.0f;
+
+				ImGui::Text("%i", iteration.depth); ImGui::NextColumn();
+				ImGui::Text("%lld", iteration.nodes); ImGui::NextColumn();
+				ImGui::Text("%lld", iteration.cutoffs); ImGui::NextColumn();
+				ImGui::Text("%.1f%%", hitRate * 100.0f); ImGui::NextColumn();
+				ImGui::Text("%.2f", iteration.branchingFactor); ImGui::NextColumn();
+				ImGui::Text("%.1f", iteration.milliseconds); ImGui::NextColumn();
+			}
+
+			ImGui::Columns(1);
+		}
+
+		ImGui::Checkbox("Write search log", &writeSearchLog);
+
+		const char* algorithms[] = { GetSearchAlgorithmName(SearchAlgorithm::MINIMAX),
+			GetSearchAlgorithmName(SearchAlgorithm::ALPHA_BETA), GetSearchAlgorithmName(SearchAlgorithm::MONTE_CARLO) };
+		int algorithm = (int)searchAlgorithm;
+		if (ImGui::Combo("Search", &algorithm, algorithms, 3)) searchAlgorithm = (SearchAlgorithm)algorithm;
+
+		if (openingBook.IsOpen()) ImGui::Checkbox("Opening book", &useOpeningBook);
+
+		ImGui::Checkbox("Ponder", &usePondering);
+		if (usePondering) ImGui::Text("Ponder hits: %i, misses: %i", ponderHits, ponderMisses);
+
+		if (searchAlgorithm == SearchAlgorithm::MONTE_CARLO)
+		{
+			ImGui::Checkbox("Time budget", &useTimeBudget);
+
+			if (useTimeBudget)	ImGui::SliderFloat("Budget (ms)", &aiTimeBudget, 10.0f, 5000.0f);
+			else				ImGui::SliderInt("Playouts", &monteCarloIterations, 1000, 2000000);
+
+			ImGui::SliderInt("Threads", &aiThreadCount, 1, 64);
+			ImGui::Text("Win rate: %.1f%%", lastMonteCarloWinRate * 100.0f);
+		}
+
+		if (searchAlgorithm == SearchAlgorithm::ALPHA_BETA)
+		{
+			ImGui::Checkbox("Time budget", &useTimeBudget);
+
+			if (useTimeBudget)
+			{
+				ImGui::SliderFloat("Budget (ms)", &aiTimeBudget, 10.0f, 5000.0f);
+			}
+			else
+			{
+				ImGui::SliderInt("Depth", &alphaBetaLevel, 1, 20);
+				if (!usePatternEvaluation) ImGui::Checkbox("Compare with minimax", &compareWithMinimax);
+			}
+
+			ImGui::SliderInt("Threads", &aiThreadCount, 1, 64);
+			ImGui::Checkbox("Pattern evaluation", &usePatternEvaluation);
+
+			const char* windows[] = { GetSearchWindowName(SearchWindow::FULL),
+				GetSearchWindowName(SearchWindow::ASPIRATION), GetSearchWindowName(SearchWindow::MTDF) };
+			int window = (int)searchWindow;
+			if (ImGui::Combo("Window", &window, windows, 3)) searchWindow = (SearchWindow)window;
+			ImGui::Text("Root searches: %lld", lastSearchStatistics.rootSearches);
+
+			ImGui::Checkbox("Endgame solver", &useEndgameSolver);
+			if (useEndgameSolver)
+			{
+				ImGui::SliderInt("Solve at empty cells", &solverEmptyCells, 1, MAX_SOLVER_EMPTY_CELLS);
+
+				if (lastMoveSolved)
+				{
+					const char* outcomes[] = { "AI loses", "Draw", "AI wins" };
+					ImGui::Text("Solved: %s in %i moves", outcomes[lastSolverResult.value + 1], lastSolverResult.distance);
+				}
+			}
+
+			const TranspositionStatistics& tableStatistics = lastSearchStatistics.table;
+			ImGui::Text("Table: %i MB, %.1f%% hits, %.1f%% collisions", (int)(transpositionTable.GetSizeInBytes() >> 20),
+				tableStatistics.GetHitRate() * 100.0f, tableStatistics.GetCollisionRate() * 100.0f);
+			ImGui::Text("First move cutoffs: %.1f%%", lastSearchStatistics.GetFirstMoveCutoffRate() * 100.0f);
+			ImGui::Checkbox("Mirror positions", &useMirrorSymmetry);
+			ImGui::Checkbox("Keep table between sessions", &useTableCache);
+			if (tableCacheLoaded > 0) ImGui::Text("Loaded %i positions from the last sessions", (int)tableCacheLoaded);
+
+			// The AI can't be using the table while it is resized
+			ImGui::SliderInt("Table MB", &transpositionTableMegabytes, 1, 1024);
+			if (!aiWorker.IsBusy() && ImGui::Button("Resize table"))
+			{
+				ponderWorker.Cancel();
+				transpositionTable.Resize(transpositionTableMegabytes);
+			}
 		}
     }
     ImGui::End();
@@ -317,6 +840,14 @@ void GUI()
 
 void Cleanup()
 {
+    // The AI threads are done, nothing touches the table anymore
+    size_t savedEntries;
+    if (useTableCache && SaveTranspositionCache(tableCacheFile, tableEvaluation, transpositionTable,
+        tableCacheDepth, tableCacheMaxEntries, savedEntries))
+    {
+        printf("Table cache: saved %i positions\n", (int)savedEntries);
+    }
+
     glDeleteBuffers(1, &coin.vbo);
     glDeleteVertexArrays(1, &coin.vao);
     glDeleteProgram(shaderProgram);
@@ -345,14 +876,24 @@ bool GetMouseClicked()
     return mouseWasClicked;
 }
 
+// Only when R goes down, holding it restarts once
+int previousRestartState;
+bool GetRestartPressed()
+{
+    int state = glfwGetKey(window, GLFW_KEY_R);
+    bool restartWasPressed = state == GLFW_PRESS && previousRestartState != GLFW_PRESS;
+    previousRestartState = state;
+    return restartWasPressed;
+}
+
 static void ResizeEvent(GLFWwindow* a_window, int a_width, int a_height)
 {
     // Set the viewport incase the window size changed
     glfwGetFramebufferSize(window, &width, &height);
 
     float windowRatio   = a_width / (float)a_height;
-    float screenRatio   = mainGameBoard.PIXEL_WIDTH / (float)mainGameBoard.PIXEL_HEIGHT;
-    float screenRatioV  = mainGameBoard.PIXEL_HEIGHT / (float)mainGameBoard.PIXEL_WIDTH;
+    float screenRatio   = boardView.PIXEL_WIDTH / (float)boardView.PIXEL_HEIGHT;
+    float screenRatioV  = boardView.PIXEL_HEIGHT / (float)boardView.PIXEL_WIDTH;
 
     if (windowRatio > screenRatio)
     {
@@ -437,6 +978,10 @@ int main()
         glfwSwapBuffers(window);
     }
 
+    // Don't leave the AI thinking about a game nobody plays anymore
+    aiWorker.Cancel();
+    ponderWorker.Cancel();
+
     // close GL context and any other GLFW resources
     glfwTerminate();
     ImGui_ImplGlfwGL3_Shutdown();